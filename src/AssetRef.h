@@ -0,0 +1,35 @@
+#ifndef ASSETREF_H
+#define ASSETREF_H
+
+#include <string>
+
+#include "lua.hpp"
+#include "LuaBridge.h"
+
+// An asset passed either by name or by the id its Load function returned. Ids index straight into a dense
+// array and only come in through the ById functions, names go through the same lookup as before
+struct AssetRef {
+	int id = -1;
+	std::string name;
+};
+
+namespace luabridge {
+	template<>
+	struct Stack<AssetRef> {
+		static void push(lua_State* L, const AssetRef& asset) {
+			if (asset.id >= 0) lua_pushinteger(L, asset.id);
+			else lua_pushlstring(L, asset.name.data(), asset.name.size());
+		}
+
+		// a number is turned into its name like any other string argument, so Input.GetKey(1) still means the "1" key
+		static AssetRef get(lua_State* L, int index) {
+			return {-1, Stack<std::string>::get(L, index)};
+		}
+
+		static bool isInstance(lua_State* L, int index) {
+			return lua_isstring(L, index) != 0;
+		}
+	};
+}
+
+#endif //ASSETREF_H
@@ -5,10 +5,15 @@
 #ifndef AUDIO_H
 #define AUDIO_H
 
+#include <filesystem>
+#include <iostream>
 #include <unordered_map>
+#include <vector>
 
 #include "SDL_mixer.h"
 
+#include "AssetRef.h"
+
 class Audio {
 public:
     static Mix_Chunk* loadAudio(const char* file, const std::string& clip) {
@@ -29,23 +34,39 @@ public:
         Mix_PlayChannel(i, mix_chunk, 0);
     }
 
-    static void playAudio(int channel, const std::string& clip, bool loop) {
-        Mix_Chunk* chunk = nullptr;
+    static Mix_Chunk* findAudio(const std::string& clip) {
         if (const auto it = audioCache.find(clip); it != audioCache.end()) {
-            chunk = it->second;
+            return it->second;
+        }
+        std::string file = "resources/audio/" + clip;
+        if (std::filesystem::exists(file+".wav")) {
+            return loadAudio((file+".wav").c_str(), clip);
+        }
+        if (std::filesystem::exists(file+".ogg")) {
+            return loadAudio((file+".ogg").c_str(), clip);
+        }
+        std::cout << "error: failed to play audio clip " << clip;
+        exit(0);
+    }
+
+    // id of a clip for Audio.Play, loading it if needed
+    static int load(const std::string& clip) {
+        if (const auto it = clipIds.find(clip); it != clipIds.end()) {
+            return it->second;
         }
+        const int id = static_cast<int>(clips.size());
+        clips.push_back(findAudio(clip));
+        clipIds.emplace(clip, id);
+        return id;
+    }
+
+    static void playAudio(int channel, const AssetRef& clip, bool loop) {
+        Mix_Chunk* chunk;
+        if (clip.id < 0) chunk = findAudio(clip.name);
+        else if (clip.id < static_cast<int>(clips.size())) chunk = clips[clip.id];
         else {
-            std::string file = "resources/audio/" + clip;
-            if (std::filesystem::exists(file+".wav")) {
-                chunk = loadAudio((file+".wav").c_str(), clip);
-            }
-            else if (std::filesystem::exists(file+".ogg")) {
-                chunk = loadAudio((file+".ogg").c_str(), clip);
-            }
-            else {
-                std::cout << "error: failed to play audio clip " << clip;
-                exit(0);
-            }
+            std::cout << "error: invalid audio clip id " << clip.id;
+            exit(0);
         }
         Mix_PlayChannel(channel, chunk, loop ? -1 : 0);
     }
@@ -60,6 +81,9 @@ public:
 
 private:
     static inline auto audioCache = std::unordered_map<std::string, Mix_Chunk*>();
+    // clips by the id Audio.Load returned for them
+    static inline std::vector<Mix_Chunk*> clips;
+    static inline std::unordered_map<std::string, int> clipIds;
 };
 
 #endif //AUDIO_H
@@ -0,0 +1,49 @@
+#ifndef COMPONENTTYPES_H
+#define COMPONENTTYPES_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef uint16_t ComponentType;
+
+// Dense ids for every component type. Native types have fixed ids, lua types are registered
+// when their files are loaded. Names are only looked up where a string crosses in from lua or a file
+class ComponentTypes {
+public:
+	static constexpr ComponentType None = 0;
+	static constexpr ComponentType Rigidbody = 1;
+	static constexpr ComponentType ParticleSystem = 2;
+	static constexpr ComponentType Transform = 3;
+
+	static ComponentType id(const std::string& name) {
+		if (const auto it = ids.find(name); it != ids.end()) {
+			return it->second;
+		}
+		const auto type = static_cast<ComponentType>(names.size());
+		names.push_back(name);
+		ids.emplace(name, type);
+		return type;
+	}
+
+	// None for names that were never registered, without registering them
+	static ComponentType find(const std::string& name) {
+		const auto it = ids.find(name);
+		return it == ids.end() ? None : it->second;
+	}
+
+	static const std::string& name(ComponentType type) {
+		return names[type];
+	}
+
+	static size_t count() {
+		return names.size();
+	}
+
+private:
+	static inline std::vector<std::string> names = {"", "Rigidbody", "ParticleSystem", "Transform"};
+	static inline std::unordered_map<std::string, ComponentType> ids = {{"Rigidbody", Rigidbody}, {"ParticleSystem", ParticleSystem}, {"Transform", Transform}};
+};
+
+#endif //COMPONENTTYPES_H
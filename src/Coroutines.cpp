@@ -0,0 +1,204 @@
+#include "Coroutines.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "EventBus.h"
+#include "FrameArena.h"
+#include "Helper.h"
+#include "luafuncs.h"
+
+int Coroutines::start(lua_State* L) {
+	luaL_checktype(L, 1, LUA_TFUNCTION);
+	const int args = lua_gettop(L) - 1;
+	lua_State* thread = lua_newthread(L);
+	lua_pushvalue(L, -1);
+	const int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	// the function and its arguments go to the new thread, the thread stays on L as the return value
+	for (int i = 1; i <= args + 1; i++) {
+		lua_pushvalue(L, i);
+	}
+	lua_xmove(L, thread, args + 1);
+	const uint64_t id = ++lastId;
+	const void* owner = caller(L);
+	running.emplace(id, Coroutine{thread, ref, owner});
+	ids.emplace(thread, id);
+	if (owner) owned[owner].push_back(id);
+	resume(id, args);
+	return 1;
+}
+
+int Coroutines::stop(lua_State* L) {
+	lua_State* thread = lua_tothread(L, 1);
+	const auto found = thread ? ids.find(thread) : ids.end();
+	if (found == ids.end()) return 0;
+	Coroutine& co = running[found->second];
+	if (co.resuming) {
+		co.stopped = true;
+		// a coroutine stopping itself ends right here
+		if (thread == L) return lua_yield(L, 0);
+		return 0;
+	}
+	finish(found->second);
+	return 0;
+}
+
+int Coroutines::waitFrames(lua_State* L) {
+	const uint64_t id = current(L, "WaitFrames");
+	const auto frames = static_cast<int>(luaL_optinteger(L, 1, 1));
+	frameWaits.push({Helper::GetFrameNumber() + std::max(frames, 1), id});
+	running[id].waiting = true;
+	return lua_yield(L, 0);
+}
+
+int Coroutines::waitSeconds(lua_State* L) {
+	const uint64_t id = current(L, "WaitSeconds");
+	timeWaits.push({now() + luaL_checknumber(L, 1), id});
+	running[id].waiting = true;
+	return lua_yield(L, 0);
+}
+
+int Coroutines::waitForEvent(lua_State* L) {
+	const uint64_t id = current(L, "WaitForEvent");
+	const uint32_t topic = lua_type(L, 1) == LUA_TNUMBER ? static_cast<uint32_t>(lua_tointeger(L, 1)) : Events::topic(luaL_checkstring(L, 1));
+	eventWaits[topic].push_back(id);
+	running[id].waiting = true;
+	return lua_yield(L, 0);
+}
+
+int Coroutines::waitUntilPhysicsStep(lua_State* L) {
+	const uint64_t id = current(L, "WaitUntilPhysicsStep");
+	physicsWaits.push_back(id);
+	running[id].waiting = true;
+	return lua_yield(L, 0);
+}
+
+void Coroutines::update() {
+	// collected first so waits made while resuming are left for a later frame
+	FrameVector<uint64_t> due;
+	const int frame = Helper::GetFrameNumber();
+	while (!frameWaits.empty() && frameWaits.top().due <= frame) {
+		due.push_back(frameWaits.top().id);
+		frameWaits.pop();
+	}
+	const double time = now();
+	while (!timeWaits.empty() && timeWaits.top().due <= time) {
+		due.push_back(timeWaits.top().id);
+		timeWaits.pop();
+	}
+	for (const uint64_t id : due) {
+		resume(id, 0);
+	}
+}
+
+void Coroutines::afterPhysicsStep() {
+	// copied out rather than swapped, so the wait list keeps its capacity from frame to frame
+	FrameVector<uint64_t> due(physicsWaits.begin(), physicsWaits.end());
+	physicsWaits.clear();
+	for (const uint64_t id : due) {
+		resume(id, 0);
+	}
+}
+
+bool Coroutines::waitingOn(uint32_t topic) {
+	const auto it = eventWaits.find(topic);
+	return it != eventWaits.end() && !it->second.empty();
+}
+
+void Coroutines::onEvent(uint32_t topic, const luabridge::LuaRef& payload) {
+	const auto it = eventWaits.find(topic);
+	if (it == eventWaits.end() || it->second.empty()) return;
+	FrameVector<uint64_t> due(it->second.begin(), it->second.end());
+	it->second.clear();
+	for (const uint64_t id : due) {
+		const auto co = running.find(id);
+		if (co == running.end()) continue;
+		payload.push();
+		lua_xmove(payload.state(), co->second.thread, 1);
+		resume(id, 1);
+	}
+}
+
+void Coroutines::stopOwnedBy(const void* owner) {
+	const auto it = owned.find(owner);
+	if (it == owned.end()) return;
+	const std::vector<uint64_t> stopping = std::move(it->second);
+	owned.erase(it);
+	for (const uint64_t id : stopping) {
+		const auto co = running.find(id);
+		if (co == running.end()) continue;
+		co->second.owner = nullptr;
+		// a coroutine that destroyed its own component ends when it yields
+		if (co->second.resuming) co->second.stopped = true;
+		else finish(id);
+	}
+}
+
+void Coroutines::resume(uint64_t id, int args) {
+	// wait entries of stopped coroutines are left behind and skipped here
+	auto it = running.find(id);
+	if (it == running.end()) return;
+	lua_State* thread = it->second.thread;
+	it->second.waiting = false;
+	it->second.resuming = true;
+	int results = 0;
+	const int status = lua_resume(thread, nullptr, args, &results);
+	// the coroutine may have started others, which can rehash the map
+	it = running.find(id);
+	it->second.resuming = false;
+	if (status == LUA_YIELD) {
+		lua_pop(thread, results);
+		if (it->second.stopped) finish(id);
+		else if (!it->second.waiting) {
+			// a plain coroutine.yield() waits a frame
+			frameWaits.push({Helper::GetFrameNumber() + 1, id});
+			it->second.waiting = true;
+		}
+		return;
+	}
+	if (status != LUA_OK) {
+		const char* message = lua_tostring(thread, -1);
+		std::string errorMessage = message ? message : "error object is not a string";
+		std::replace(errorMessage.begin(), errorMessage.end(), '\\', '/');
+		std::cout << "\033[31m" << "Coroutine : " << errorMessage << "\033[0m" << std::endl;
+	}
+	finish(id);
+}
+
+void Coroutines::finish(uint64_t id) {
+	const auto it = running.find(id);
+	if (it == running.end()) return;
+	ids.erase(it->second.thread);
+	if (const auto list = owned.find(it->second.owner); list != owned.end()) {
+		std::vector<uint64_t>& owners = list->second;
+		owners.erase(std::find(owners.begin(), owners.end(), id));
+		if (owners.empty()) owned.erase(list);
+	}
+	luaL_unref(luaState, LUA_REGISTRYINDEX, it->second.ref);
+	running.erase(it);
+}
+
+uint64_t Coroutines::current(lua_State* L, const char* function) {
+	const auto it = ids.find(L);
+	if (it == ids.end()) {
+		luaL_error(L, "%s can only be called from a coroutine started with Application.StartCoroutine", function);
+	}
+	return it->second;
+}
+
+const void* Coroutines::caller(lua_State* L) {
+	lua_Debug ar;
+	if (!lua_getstack(L, 1, &ar)) return nullptr;
+	const char* name = lua_getlocal(L, &ar, 1);
+	if (!name) return nullptr;
+	const void* owner = std::strcmp(name, "self") == 0 && lua_istable(L, -1) ? lua_topointer(L, -1) : nullptr;
+	lua_pop(L, 1);
+	return owner;
+}
+
+double Coroutines::now() {
+	static const auto startTime = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
@@ -0,0 +1,76 @@
+#ifndef COROUTINES_H
+#define COROUTINES_H
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "lua.hpp"
+#include "LuaBridge.h"
+
+// Engine managed lua coroutines. A coroutine suspends itself by calling one of the wait functions and is
+// only resumed once what it waits for has happened: frame and time waits sit in heaps ordered by when
+// they are due, event and physics waits in lists that are emptied when they fire.
+// Coroutines live outside every component table so saves never contain them. One started from a method
+// of a lua component belongs to that component and is stopped when the component is destroyed
+class Coroutines {
+public:
+	// lua_CFunctions, bound in the Application namespace
+	static int start(lua_State* L);
+	static int stop(lua_State* L);
+	static int waitFrames(lua_State* L);
+	static int waitSeconds(lua_State* L);
+	static int waitForEvent(lua_State* L);
+	static int waitUntilPhysicsStep(lua_State* L);
+
+	// resumes the frame and time waits that are due, once per frame after the actors' update
+	static void update();
+	static void afterPhysicsStep();
+	[[nodiscard]] static bool waitingOn(uint32_t topic);
+	// resumes every coroutine waiting on topic with the payload as the result of WaitForEvent
+	static void onEvent(uint32_t topic, const luabridge::LuaRef& payload);
+	// stops the coroutines started from a method of the component whose instance table this is
+	static void stopOwnedBy(const void* owner);
+	[[nodiscard]] static bool anyOwned() { return !owned.empty(); }
+
+private:
+	struct Coroutine {
+		lua_State* thread;
+		// registry reference that keeps the thread alive
+		int ref;
+		// instance table of the component that started it, nullptr if none
+		const void* owner = nullptr;
+		bool waiting = false;
+		// inside lua_resume, stopping has to wait until it returns
+		bool resuming = false;
+		bool stopped = false;
+	};
+
+	template <typename T> struct Wait {
+		T due;
+		uint64_t id;
+		bool operator>(const Wait& other) const { return due > other.due; }
+	};
+	template <typename T> using WaitHeap = std::priority_queue<Wait<T>, std::vector<Wait<T>>, std::greater<>>;
+
+	static inline std::unordered_map<uint64_t, Coroutine> running;
+	static inline std::unordered_map<lua_State*, uint64_t> ids;
+	static inline uint64_t lastId = 0;
+	static inline WaitHeap<int> frameWaits;
+	static inline WaitHeap<double> timeWaits;
+	static inline std::unordered_map<uint32_t, std::vector<uint64_t>> eventWaits;
+	static inline std::vector<uint64_t> physicsWaits;
+	static inline std::unordered_map<const void*, std::vector<uint64_t>> owned;
+
+	static void resume(uint64_t id, int args);
+	static void finish(uint64_t id);
+	// the id of the coroutine L is, raises a lua error outside of one
+	static uint64_t current(lua_State* L, const char* function);
+	// the self table of the lua function that called into L, nullptr when the caller isn't a method
+	static const void* caller(lua_State* L);
+	static double now();
+};
+
+#endif //COROUTINES_H
@@ -1,41 +1,186 @@
 #include "EventBus.h"
 
-#include <algorithm>
-
 #include "lua.hpp"
 #include "LuaBridge.h"
 
-std::unordered_map<std::string, std::vector<std::pair<luabridge::LuaRef, luabridge::LuaRef>>> Events::subscriptions;
-std::vector<Event> Events::removedThisFrame;
-std::vector<Event> Events::addedThisFrame;
+#include "Coroutines.h"
+#include "luafuncs.h"
+#include "scene.hpp"
+
+using luabridge::LuaRef;
+
+std::deque<std::vector<Subscriber>> Events::topics;
+std::unordered_map<std::string, uint32_t> Events::topicIds;
+std::vector<std::string> Events::topicNames;
+std::vector<DeferredQueue> Events::deferred;
+std::vector<uint32_t> Events::deferredOrder;
+std::vector<Subscription> Events::slots;
+std::vector<uint32_t> Events::freeSlots;
+std::vector<Subscriber> Events::addedThisFrame;
+std::vector<uint64_t> Events::removedThisFrame;
+std::vector<Event> Events::removedByValueThisFrame;
+
+Event::Event(uint32_t topic, const luabridge::LuaRef& comp, const luabridge::LuaRef& func)
+: topic(topic), component(comp), function(func) {}
+
+uint32_t Events::topic(const std::string& type) {
+    if (const auto it = topicIds.find(type); it != topicIds.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<uint32_t>(topics.size());
+    topics.emplace_back();
+    topicIds.emplace(type, id);
+    topicNames.push_back(type);
+    return id;
+}
+
+uint64_t Events::subscribe(const std::string& type, const luabridge::LuaRef& component, const luabridge::LuaRef& function) {
+    return add(type, component, function, false);
+}
 
-Event::Event(std::string type, const luabridge::LuaRef& comp, const luabridge::LuaRef& func)
-: type(std::move(type)), component(comp), function(func) {}
+uint64_t Events::subscribeBatch(const std::string& type, const luabridge::LuaRef& component, const luabridge::LuaRef& function) {
+    return add(type, component, function, true);
+}
 
-void Events::subscribe(const std::string& type, const luabridge::LuaRef& component, const luabridge::LuaRef& function) {
-    addedThisFrame.emplace_back(type, component, function);
+uint64_t Events::add(const std::string& type, const luabridge::LuaRef& component, const luabridge::LuaRef& function, bool batch) {
+    uint32_t slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        slot = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+    slots[slot].topic = topic(type);
+    addedThisFrame.push_back({component, function, slot, batch});
+    return static_cast<uint64_t>(slots[slot].generation) << 32 | slot;
 }
 
-void Events::unsubscribe(const std::string& type, const luabridge::LuaRef& component, const luabridge::LuaRef& function) {
-    removedThisFrame.emplace_back(type, component, function);
+void Events::unsubscribe(const luabridge::LuaRef& handle, const luabridge::LuaRef& component, const luabridge::LuaRef& function) {
+    if (handle.isNumber()) {
+        removedThisFrame.push_back(handle.cast<uint64_t>());
+    }
+    else if (handle.isString()) {
+        if (const auto it = topicIds.find(handle.cast<std::string>()); it != topicIds.end()) {
+            removedByValueThisFrame.emplace_back(it->second, component, function);
+        }
+    }
 }
 
-void Events::publish(const std::string& type, const luabridge::LuaRef& object) {
-    const auto& vec = subscriptions[type];
-    for (auto& pair : vec) {
-        pair.second(pair.first, object);
+// topics nobody subscribed to are never created
+bool Events::findTopic(const luabridge::LuaRef& type, uint32_t& id) {
+    if (type.isNumber()) {
+        id = type.cast<uint32_t>();
+        return id < topics.size();
     }
+    const auto it = topicIds.find(type.cast<std::string>());
+    if (it == topicIds.end()) return false;
+    id = it->second;
+    return true;
+}
+
+void Events::publish(const luabridge::LuaRef& type, const luabridge::LuaRef& object) {
+    uint32_t id;
+    if (!findTopic(type, id)) return;
+    if (Coroutines::waitingOn(id)) Coroutines::onEvent(id, object);
+    LuaRef batch(luaState);
+    // subscription changes wait for lateUpdate, so the list can't change under the loop
+    for (const Subscriber& subscriber : topics[id]) {
+        if (subscriber.batch) {
+            if (batch.isNil()) {
+                batch = luabridge::newTable(luaState);
+                batch[1] = object;
+            }
+            subscriber.function(subscriber.component, batch);
+        }
+        else subscriber.function(subscriber.component, object);
+    }
+}
+
+void Events::publishDeferred(const luabridge::LuaRef& type, const luabridge::LuaRef& object, const luabridge::LuaRef& coalesceKey) {
+    uint32_t id;
+    if (!findTopic(type, id) || (topics[id].empty() && !Coroutines::waitingOn(id))) return;
+    if (deferred.size() < topics.size()) deferred.resize(topics.size());
+    DeferredQueue& queue = deferred[id];
+    if (queue.payloads.empty()) deferredOrder.push_back(id);
+    if (!coalesceKey.isNil()) {
+        const auto [it, added] = queue.keys.try_emplace(coalesceKey.tostring(), queue.payloads.size());
+        if (!added) {
+            queue.payloads[it->second] = object;
+            return;
+        }
+    }
+    queue.payloads.push_back(object);
+}
+
+void Events::deliverDeferred() {
+    std::vector<uint32_t> order;
+    std::swap(order, deferredOrder);
+    for (const uint32_t id : order) {
+        DeferredQueue queue;
+        std::swap(queue, deferred[id]);
+        if (Coroutines::waitingOn(id)) Coroutines::onEvent(id, queue.payloads.front());
+        LuaRef batch(luaState);
+        for (const Subscriber& subscriber : topics[id]) {
+            try {
+                if (subscriber.batch) {
+                    if (batch.isNil()) {
+                        batch = luabridge::newTable(luaState);
+                        for (size_t i = 0; i < queue.payloads.size(); i++) {
+                            batch[i + 1] = queue.payloads[i];
+                        }
+                    }
+                    subscriber.function(subscriber.component, batch);
+                }
+                else {
+                    for (const LuaRef& payload : queue.payloads) {
+                        subscriber.function(subscriber.component, payload);
+                    }
+                }
+            }
+            catch (const luabridge::LuaException& e) {
+                ReportError(topicNames[id], e);
+            }
+        }
+    }
+}
+
+void Events::remove(uint32_t slot) {
+    Subscription& sub = slots[slot];
+    auto& vec = topics[sub.topic];
+    if (sub.index != vec.size() - 1) {
+        vec[sub.index] = std::move(vec.back());
+        slots[vec[sub.index].slot].index = sub.index;
+    }
+    vec.pop_back();
+    sub.active = false;
+    sub.generation++;
+    freeSlots.push_back(slot);
 }
 
 void Events::lateUpdate() {
-    for (const auto& event : addedThisFrame) {
-        subscriptions[event.type].emplace_back(event.component, event.function);
+    for (auto& subscriber : addedThisFrame) {
+        Subscription& sub = slots[subscriber.slot];
+        auto& vec = topics[sub.topic];
+        sub.index = static_cast<uint32_t>(vec.size());
+        sub.active = true;
+        vec.push_back(std::move(subscriber));
+    }
+    for (const uint64_t handle : removedThisFrame) {
+        const auto slot = static_cast<uint32_t>(handle);
+        if (slot < slots.size() && slots[slot].active && slots[slot].generation == handle >> 32) remove(slot);
     }
-    for (const auto& event : removedThisFrame) {
-        auto& vec = subscriptions[event.type];
-        std::pair pair = {event.component, event.function};
-        vec.erase(std::find(vec.begin(), vec.end(), pair));
+    for (const auto& event : removedByValueThisFrame) {
+        const auto& vec = topics[event.topic];
+        for (const Subscriber& subscriber : vec) {
+            if (subscriber.component == event.component && subscriber.function == event.function) {
+                remove(subscriber.slot);
+                break;
+            }
+        }
     }
     addedThisFrame.clear();
     removedThisFrame.clear();
+    removedByValueThisFrame.clear();
 }
@@ -4,31 +4,85 @@
 #include "lua.hpp"
 #include "LuaBridge.h"
 
+#include <cstdint>
+#include <deque>
 #include <vector>
 #include <unordered_map>
 #include <string>
 
+// queued Event.Unsubscribe(type, component, function) of scripts that don't keep the handle
 struct Event {
-	std::string type;
+	uint32_t topic;
 	luabridge::LuaRef component;
 	luabridge::LuaRef function;
-	Event(std::string, const luabridge::LuaRef&, const luabridge::LuaRef&);
+	Event(uint32_t, const luabridge::LuaRef&, const luabridge::LuaRef&);
+};
+
+struct Subscriber {
+	luabridge::LuaRef component;
+	luabridge::LuaRef function;
+	uint32_t slot;
+	// called with an array of payloads instead of one payload per call
+	bool batch;
+};
+
+// deferred payloads of one topic. Payloads published with a coalesce key replace the earlier one with that key
+struct DeferredQueue {
+	std::vector<luabridge::LuaRef> payloads;
+	std::unordered_map<std::string, size_t> keys;
+};
+
+// where a handle's subscriber lives. The generation is part of the handle so stale handles are ignored
+struct Subscription {
+	uint32_t topic = 0;
+	uint32_t index = 0;
+	uint32_t generation = 0;
+	bool active = false;
 };
 
 class Events {
 public:
+	// interns the topic, publishing with the returned id skips the string lookup
+	static uint32_t topic(const std::string& type);
+
+	static uint64_t subscribe(const std::string& type, const luabridge::LuaRef& component, const luabridge::LuaRef& function);
+
+	// like subscribe, but function gets an array of every payload delivered at once
+	static uint64_t subscribeBatch(const std::string& type, const luabridge::LuaRef& component, const luabridge::LuaRef& function);
+
+	// takes a handle from subscribe, or the type, component and function it was subscribed with
+	static void unsubscribe(const luabridge::LuaRef& handle, const luabridge::LuaRef& component, const luabridge::LuaRef& function);
 
-	static void subscribe(const std::string& type, const luabridge::LuaRef& component, const luabridge::LuaRef& function);
+	// type is a topic name or id
+	static void publish(const luabridge::LuaRef& type, const luabridge::LuaRef& object);
 
-	static void unsubscribe(const std::string& type, const luabridge::LuaRef& component, const luabridge::LuaRef& function);
+	// queues the payload until deliverDeferred, coalesceKey is optional
+	static void publishDeferred(const luabridge::LuaRef& type, const luabridge::LuaRef& object, const luabridge::LuaRef& coalesceKey);
 
-	static void publish(const std::string& type, const luabridge::LuaRef& object);
+	// sends every queued payload, called once per frame after the actors' lateUpdate. Errors in one
+	// listener are reported without stopping the rest, events deferred by listeners wait for the next frame
+	static void deliverDeferred();
 
 	static void lateUpdate();
 
-	static std::unordered_map<std::string, std::vector<std::pair<luabridge::LuaRef, luabridge::LuaRef>>> subscriptions;
-	static std::vector<Event> addedThisFrame, removedThisFrame;
+	// a deque so a topic interned by a callback doesn't move the subscribers being published to
+	static std::deque<std::vector<Subscriber>> topics;
+	static std::unordered_map<std::string, uint32_t> topicIds;
+	static std::vector<std::string> topicNames;
+	// indexed by topic id, grown as topics are deferred to
+	static std::vector<DeferredQueue> deferred;
+	// topics with queued payloads, in the order they were first deferred to this frame
+	static std::vector<uint32_t> deferredOrder;
+	static std::vector<Subscription> slots;
+	static std::vector<uint32_t> freeSlots;
+	static std::vector<Subscriber> addedThisFrame;
+	static std::vector<uint64_t> removedThisFrame;
+	static std::vector<Event> removedByValueThisFrame;
 
+private:
+	static uint64_t add(const std::string& type, const luabridge::LuaRef& component, const luabridge::LuaRef& function, bool batch);
+	static bool findTopic(const luabridge::LuaRef& type, uint32_t& id);
+	static void remove(uint32_t slot);
 };
 
-#endif
\ No newline at end of file
+#endif
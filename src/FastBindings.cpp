@@ -0,0 +1,131 @@
+#include "FastBindings.h"
+
+#include <string>
+
+#include "RigidBody.h"
+#include "scene.hpp"
+
+namespace {
+	// a Vector2, or x and y as two numbers
+	b2::Vec2 vectorArg(lua_State* L, int index) {
+		if (lua_type(L, index) == LUA_TNUMBER) {
+			return {static_cast<float>(lua_tonumber(L, index)), static_cast<float>(luaL_checknumber(L, index + 1))};
+		}
+		return luabridge::Stack<b2::Vec2>::get(L, index);
+	}
+
+	int pushVector(lua_State* L, const b2::Vec2& v) {
+		luabridge::Stack<b2::Vec2>::push(L, v);
+		return 1;
+	}
+
+	// pushes a component's lua value without copying its LuaRef
+	int pushComponent(lua_State* L, const Component* component) {
+		if (!component) {
+			lua_pushnil(L);
+			return 1;
+		}
+		component->first.push();
+		if (component->first.state() != L) lua_xmove(component->first.state(), L, 1);
+		return 1;
+	}
+
+	int rbGetPosition(lua_State* L) {
+		return pushVector(L, FastBindings::self<RigidBody>(L)->getPosition());
+	}
+
+	int rbSetPosition(lua_State* L) {
+		FastBindings::self<RigidBody>(L)->setPosition(vectorArg(L, 2));
+		return 0;
+	}
+
+	int rbGetRotation(lua_State* L) {
+		lua_pushnumber(L, FastBindings::self<RigidBody>(L)->getRotation());
+		return 1;
+	}
+
+	int rbSetRotation(lua_State* L) {
+		FastBindings::self<RigidBody>(L)->setRotation(static_cast<float>(luaL_checknumber(L, 2)));
+		return 0;
+	}
+
+	int rbGetVelocity(lua_State* L) {
+		return pushVector(L, FastBindings::self<RigidBody>(L)->getVelocity());
+	}
+
+	int rbSetVelocity(lua_State* L) {
+		FastBindings::self<RigidBody>(L)->setVelocity(vectorArg(L, 2));
+		return 0;
+	}
+
+	int rbGetAngularVelocity(lua_State* L) {
+		lua_pushnumber(L, FastBindings::self<RigidBody>(L)->getAngularVelocity());
+		return 1;
+	}
+
+	int rbSetAngularVelocity(lua_State* L) {
+		FastBindings::self<RigidBody>(L)->setAngularVelocity(static_cast<float>(luaL_checknumber(L, 2)));
+		return 0;
+	}
+
+	int rbAddForce(lua_State* L) {
+		FastBindings::self<RigidBody>(L)->AddForce(vectorArg(L, 2));
+		return 0;
+	}
+
+	int rbGetPositionXY(lua_State* L) {
+		return FastBindings::self<RigidBody>(L)->getPositionXY(L);
+	}
+
+	int rbGetVelocityXY(lua_State* L) {
+		return FastBindings::self<RigidBody>(L)->getVelocityXY(L);
+	}
+
+	int actorGetPosition(lua_State* L) {
+		return pushVector(L, FastBindings::self<Actor>(L)->getPosition());
+	}
+
+	int actorSetPosition(lua_State* L) {
+		FastBindings::self<Actor>(L)->setPosition(vectorArg(L, 2));
+		return 0;
+	}
+
+	int actorGetPositionXY(lua_State* L) {
+		return FastBindings::self<Actor>(L)->getPositionXY(L);
+	}
+
+	int actorGetComponent(lua_State* L) {
+		const Actor* actor = FastBindings::self<Actor>(L);
+		const auto it = actor->componentsByType.find(ComponentTypes::find(luaL_checkstring(L, 2)));
+		return pushComponent(L, it == actor->componentsByType.end() || it->second.empty() ? nullptr : it->second[0]);
+	}
+
+	int actorGetComponentByKey(lua_State* L) {
+		const Actor* actor = FastBindings::self<Actor>(L);
+		const auto it = actor->componentsByKey.find(luaL_checkstring(L, 2));
+		return pushComponent(L, it == actor->componentsByKey.end() ? nullptr : it->second);
+	}
+}
+
+void registerFastBindings(lua_State* L) {
+	FastBindings::replaceMethods<RigidBody>(L, {
+		{"GetPosition", rbGetPosition},
+		{"SetPosition", rbSetPosition},
+		{"GetRotation", rbGetRotation},
+		{"SetRotation", rbSetRotation},
+		{"GetVelocity", rbGetVelocity},
+		{"SetVelocity", rbSetVelocity},
+		{"GetAngularVelocity", rbGetAngularVelocity},
+		{"SetAngularVelocity", rbSetAngularVelocity},
+		{"AddForce", rbAddForce},
+		{"GetPositionXY", rbGetPositionXY},
+		{"GetVelocityXY", rbGetVelocityXY},
+	});
+	FastBindings::replaceMethods<Actor>(L, {
+		{"GetPosition", actorGetPosition},
+		{"SetPosition", actorSetPosition},
+		{"GetPositionXY", actorGetPositionXY},
+		{"GetComponent", actorGetComponent},
+		{"GetComponentByKey", actorGetComponentByKey},
+	});
+}
@@ -0,0 +1,60 @@
+#ifndef FASTBINDINGS_H
+#define FASTBINDINGS_H
+
+#include <initializer_list>
+
+#include "lua.hpp"
+#include "LuaBridge.h"
+
+// Hand written lua_CFunctions for the Rigidbody and Actor methods scripts call most, replacing the
+// LuaBridge versions of the same name. Must run after those classes are registered
+void registerFastBindings(lua_State* L);
+
+// What the hand written methods are built from, shared with tools/binding_bench.cpp so the benchmark
+// measures the same code the engine runs
+class FastBindings {
+public:
+	struct Method {
+		const char* name;
+		lua_CFunction function;
+	};
+
+	// the object a method was called on. Engine objects always reach lua as non const pointers to their own
+	// class, so one metatable compare replaces LuaBridge's walk up the class chain. Anything else takes
+	// LuaBridge's checked path, which raises the usual error for a wrong argument
+	template<class T>
+	static T* self(lua_State* L) {
+		if (lua_getmetatable(L, 1)) {
+			const bool exact = lua_topointer(L, -1) == classMetatable<T>;
+			lua_pop(L, 1);
+			if (exact) return static_cast<T*>(UserdataAccess::pointer(lua_touserdata(L, 1)));
+		}
+		return luabridge::detail::Userdata::get<T>(L, 1, false);
+	}
+
+	// sets the methods on T's class table, over any LuaBridge method of the same name
+	template<class T>
+	static void replaceMethods(lua_State* L, std::initializer_list<Method> methods) {
+		lua_rawgetp(L, LUA_REGISTRYINDEX, luabridge::detail::getClassRegistryKey<T>());
+		classMetatable<T> = lua_topointer(L, -1);
+		for (const Method& method : methods) {
+			lua_pushcfunction(L, method.function);
+			luabridge::rawsetfield(L, -2, method.name);
+		}
+		lua_pop(L, 1);
+	}
+
+private:
+	// reads the object pointer LuaBridge keeps at the start of its userdata, which it only exposes to subclasses
+	struct UserdataAccess : luabridge::detail::Userdata {
+		static void* pointer(void* userdata) {
+			return static_cast<Userdata*>(userdata)->*(&UserdataAccess::m_p);
+		}
+	};
+
+	// metatable of the non const userdata of T, set once the class is registered
+	template<class T>
+	static inline const void* classMetatable = nullptr;
+};
+
+#endif //FASTBINDINGS_H
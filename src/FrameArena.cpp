@@ -0,0 +1,28 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+	const auto base = reinterpret_cast<uintptr_t>(block.data());
+	const size_t start = (base + offset + alignment - 1) / alignment * alignment - base;
+	if (start + bytes <= block.size()) {
+		offset = start + bytes;
+		peakUsed = std::max(peakUsed, offset + overflowUsed);
+		return block.data() + start;
+	}
+	// operator new aligns to max_align_t, enough for anything the engine keeps in the arena
+	overflow.emplace_back(bytes);
+	overflowUsed += bytes;
+	peakUsed = std::max(peakUsed, offset + overflowUsed);
+	return overflow.back().data();
+}
+
+void FrameArena::reset() {
+	if (!overflow.empty()) {
+		block = std::vector<std::byte>(offset + overflowUsed + block.size() / 2);
+		overflow.clear();
+		overflowUsed = 0;
+	}
+	offset = 0;
+}
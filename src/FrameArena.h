@@ -0,0 +1,52 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the frame, reset at the top of the main loop.
+// Memory is never freed on its own, so anything from it must not outlive the frame. Main thread only
+class FrameArena {
+public:
+	static void* allocate(size_t bytes, size_t alignment);
+	// drops everything allocated this frame. After a frame that overflowed the block, the block grows to
+	// that frame's peak so later frames need a single block again
+	static void reset();
+
+	static size_t capacity() { return block.size(); }
+	static size_t used() { return offset; }
+	static size_t peak() { return peakUsed; }
+
+private:
+	static inline std::vector<std::byte> block = std::vector<std::byte>(256 * 1024);
+	static inline size_t offset = 0;
+	// blocks taken once the main one ran out this frame, freed at the next reset
+	static inline std::vector<std::vector<std::byte>> overflow;
+	static inline size_t overflowUsed = 0;
+	static inline size_t peakUsed = 0;
+};
+
+// STL allocator on the frame arena, deallocate does nothing
+template<class T>
+struct FrameAllocator {
+	using value_type = T;
+
+	FrameAllocator() = default;
+	template<class U>
+	FrameAllocator(const FrameAllocator<U>&) {}
+
+	T* allocate(size_t n) {
+		return static_cast<T*>(FrameArena::allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T*, size_t) {}
+
+	template<class U>
+	bool operator==(const FrameAllocator<U>&) const { return true; }
+	template<class U>
+	bool operator!=(const FrameAllocator<U>&) const { return false; }
+};
+
+template<class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+#endif //FRAMEARENA_H
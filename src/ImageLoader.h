@@ -14,11 +14,14 @@
 #include <filesystem>
 #include <iostream>
 #include <unordered_map>
+#include <vector>
 
+#include "AssetRef.h"
+#include "TextureRegistry.h"
 
-inline std::unordered_map<std::string, SDL_Texture*> cache;
+inline std::unordered_map<std::string, TextureId> cache;
 
-inline SDL_Texture* getImage(SDL_Renderer* renderer, const std::string& file) {
+inline TextureId getImage(SDL_Renderer* renderer, const std::string& file) {
     if (const auto it = cache.find(file); it != cache.end()) {
         return it->second;
     }
@@ -29,11 +32,34 @@ inline SDL_Texture* getImage(SDL_Renderer* renderer, const std::string& file) {
         std::cout << "error: missing image " + file;
         exit(0);
     }
-    SDL_Texture* texture = IMG_LoadTexture(renderer, path.c_str());
+    const TextureId texture = TextureRegistry::add(IMG_LoadTexture(renderer, path.c_str()));
     cache[file] = texture;
     return texture;
 }
 
+// images by the id Image.Load returned for them
+inline std::vector<TextureId> images;
+inline std::unordered_map<std::string, int> imageIds;
+
+inline int loadImage(SDL_Renderer* renderer, const std::string& file) {
+    if (const auto it = imageIds.find(file); it != imageIds.end()) {
+        return it->second;
+    }
+    const int id = static_cast<int>(images.size());
+    images.push_back(getImage(renderer, file));
+    imageIds.emplace(file, id);
+    return id;
+}
+
+inline TextureId getImage(SDL_Renderer* renderer, const AssetRef& image) {
+    if (image.id < 0) return getImage(renderer, image.name);
+    if (image.id >= static_cast<int>(images.size())) {
+        std::cout << "error: invalid image id " << image.id;
+        exit(0);
+    }
+    return images[image.id];
+}
+
 inline void createDefaultParticle(SDL_Renderer* renderer, const std::string& name) {
     SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 8, 8, 32, SDL_PIXELFORMAT_RGBA8888);
 
@@ -41,7 +67,7 @@ inline void createDefaultParticle(SDL_Renderer* renderer, const std::string& nam
     SDL_FillRect(surface, nullptr, white);
     SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
 
-    cache[name] = texture;
+    cache[name] = TextureRegistry::add(texture);
 }
 
 
@@ -119,24 +119,33 @@ void InputManager::processEvent(SDL_Event *e) {
     }
 }
 
-bool InputManager::getKey(const std::string& key) {
+int InputManager::keyCode(const std::string& key) {
     auto it = keycode_to_scancode.find(key);
-    if (it == keycode_to_scancode.end()) return false;
-    SDL_Scancode code = it->second;
+    if (it == keycode_to_scancode.end()) return -1;
+    return it->second;
+}
+
+// scancode of a key argument, -1 if there is no such key
+static int scancode(const AssetRef& key) {
+    if (key.id < 0) return InputManager::keyCode(key.name);
+    return key.id < SDL_NUM_SCANCODES ? key.id : -1;
+}
+
+bool InputManager::getKey(const AssetRef& key) {
+    const int code = scancode(key);
+    if (code < 0) return false;
     return keys[code] == KeyDown || keys[code] == KeyJustDown;
 }
 
-bool InputManager::getKeyDown(const std::string& key) {
-    auto it = keycode_to_scancode.find(key);
-    if (it == keycode_to_scancode.end()) return false;
-    SDL_Scancode code = it->second;
+bool InputManager::getKeyDown(const AssetRef& key) {
+    const int code = scancode(key);
+    if (code < 0) return false;
     return keys[code] == KeyJustDown;
 }
 
-bool InputManager::getKeyUp(const std::string& key) {
-    auto it = keycode_to_scancode.find(key);
-    if (it == keycode_to_scancode.end()) return false;
-    SDL_Scancode code = it->second;
+bool InputManager::getKeyUp(const AssetRef& key) {
+    const int code = scancode(key);
+    if (code < 0) return false;
     return keys[code] == KeyJustUp;
 }
 
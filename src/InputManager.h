@@ -10,6 +10,8 @@
 
 #include "SDL.h"
 
+#include "AssetRef.h"
+
 #include "../glm/glm.hpp"
 
 enum KeyState {
@@ -22,9 +24,12 @@ public:
     static void lateUpdate();
     static void processEvent(SDL_Event* e);
 
-    static bool getKey(const std::string& key);
-    static bool getKeyDown(const std::string& key);
-    static bool getKeyUp(const std::string& key);
+    // key is a name, or the code Input.KeyCode returned for it
+    static bool getKey(const AssetRef& key);
+    static bool getKeyDown(const AssetRef& key);
+    static bool getKeyUp(const AssetRef& key);
+    // -1 for names that aren't a key
+    static int keyCode(const std::string& key);
 
     static bool getMouseButton(uint8_t num);
     static bool getMouseButtonDown(uint8_t num);
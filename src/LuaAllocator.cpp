@@ -0,0 +1,106 @@
+#include "LuaAllocator.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+	int panic(lua_State* L) {
+		const char* message = lua_tostring(L, -1);
+		std::cout << "PANIC: unprotected error in call to Lua API (" << (message ? message : "error object is not a string") << ")" << std::endl;
+		return 0;
+	}
+}
+
+lua_State* LuaAllocator::newState() {
+	// owned by the state for as long as the program runs, engine states are never closed
+	lua_State* L = lua_newstate(allocate, new LuaAllocator());
+	if (L) lua_atpanic(L, panic);
+	return L;
+}
+
+LuaAllocator* LuaAllocator::of(lua_State* L) {
+	void* ud = nullptr;
+	return lua_getallocf(L, &ud) == allocate ? static_cast<LuaAllocator*>(ud) : nullptr;
+}
+
+void* LuaAllocator::take(size_t size) {
+	SizeClass& sizeClass = classes[classOf(size)];
+	sizeClass.inUse++;
+	sizeClass.allocations++;
+	requestedSmall += size;
+	if (void* block = sizeClass.free) {
+		sizeClass.free = *static_cast<void**>(block);
+		return block;
+	}
+	const size_t blockSize = (classOf(size) + 1) * granularity;
+	if (left < blockSize) {
+		// the tail of the old chunk is too small for this class and is left unused
+		next = static_cast<char*>(std::malloc(chunkSize));
+		if (!next) {
+			left = 0;
+			sizeClass.inUse--;
+			requestedSmall -= size;
+			return nullptr;
+		}
+		chunks.push_back(next);
+		chunkBytes += chunkSize;
+		left = chunkSize;
+	}
+	void* block = next;
+	next += blockSize;
+	left -= blockSize;
+	sizeClass.reserved++;
+	return block;
+}
+
+void LuaAllocator::give(void* block, size_t size) {
+	SizeClass& sizeClass = classes[classOf(size)];
+	*static_cast<void**>(block) = sizeClass.free;
+	sizeClass.free = block;
+	sizeClass.inUse--;
+	requestedSmall -= size;
+}
+
+void* LuaAllocator::allocate(void* ud, void* ptr, size_t osize, size_t nsize) {
+	auto* self = static_cast<LuaAllocator*>(ud);
+	// lua passes a type tag as osize for new blocks
+	if (!ptr) osize = 0;
+	if (nsize == 0) {
+		if (!ptr) return nullptr;
+		if (osize <= maxSmall) self->give(ptr, osize);
+		else {
+			self->largeBytes -= osize;
+			std::free(ptr);
+		}
+		return nullptr;
+	}
+	if (osize > maxSmall && nsize > maxSmall) {
+		void* block = std::realloc(ptr, nsize);
+		if (block) self->largeBytes = self->largeBytes - osize + nsize;
+		return block;
+	}
+	if (ptr && osize <= maxSmall && nsize <= maxSmall && classOf(osize) == classOf(nsize)) {
+		self->requestedSmall = self->requestedSmall - osize + nsize;
+		return ptr;
+	}
+	void* block;
+	if (nsize <= maxSmall) block = self->take(nsize);
+	else {
+		block = std::malloc(nsize);
+		if (block) self->largeBytes += nsize;
+	}
+	// on failure lua keeps using the old block
+	if (!block || !ptr) return block;
+	std::memcpy(block, ptr, osize < nsize ? osize : nsize);
+	if (osize <= maxSmall) self->give(ptr, osize);
+	else {
+		self->largeBytes -= osize;
+		std::free(ptr);
+	}
+	return block;
+}
+
+LuaAllocator::~LuaAllocator() {
+	for (char* chunk : chunks) std::free(chunk);
+}
@@ -0,0 +1,57 @@
+#ifndef LUAALLOCATOR_H
+#define LUAALLOCATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lua.hpp"
+
+// lua_Alloc for the engine's lua states. Blocks up to 256 bytes, which is nearly everything lua allocates,
+// come from free lists of 16 byte size classes carved out of 64KB chunks, larger ones from malloc.
+// One allocator per state: a state is only ever used by one thread at a time, so the lists need no locks
+// and lane states get their own lists on their own threads
+class LuaAllocator {
+public:
+	static constexpr size_t granularity = 16;
+	static constexpr size_t classCount = 16;
+	static constexpr size_t maxSmall = granularity * classCount;
+	static constexpr size_t chunkSize = 64 * 1024;
+
+	struct SizeClass {
+		void* free = nullptr;
+		// blocks lua holds, and blocks carved from chunks so far
+		size_t inUse = 0;
+		size_t reserved = 0;
+		uint64_t allocations = 0;
+	};
+
+	std::array<SizeClass, classCount> classes;
+	// bytes lua asked for in small blocks it holds, short of the class sizes by the rounding waste
+	size_t requestedSmall = 0;
+	size_t largeBytes = 0;
+	size_t chunkBytes = 0;
+
+	// a state using a new allocator, with the same panic handler luaL_newstate sets
+	static lua_State* newState();
+	// the allocator of a state made by newState, nullptr for any other state
+	static LuaAllocator* of(lua_State* L);
+	static void* allocate(void* ud, void* ptr, size_t osize, size_t nsize);
+
+	LuaAllocator() = default;
+	LuaAllocator(const LuaAllocator&) = delete;
+	LuaAllocator& operator=(const LuaAllocator&) = delete;
+	~LuaAllocator();
+
+private:
+	std::vector<char*> chunks;
+	char* next = nullptr;
+	size_t left = 0;
+
+	static size_t classOf(size_t size) { return (size - 1) / granularity; }
+	void* take(size_t size);
+	void give(void* block, size_t size);
+};
+
+#endif //LUAALLOCATOR_H
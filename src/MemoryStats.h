@@ -0,0 +1,24 @@
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+
+#include <cstdint>
+
+#include "lua.hpp"
+#include "Box2D/Box2D.hpp"
+
+// Counters reported by Application.GetMemoryStats
+class MemoryStats {
+public:
+	// Vector2 userdata that the XY variants of vector getters and setters kept scripts from creating
+	static inline uint64_t vectorsAvoided = 0;
+
+	// returns a vector to lua as two numbers, for the XY getters
+	static int pushXY(lua_State* L, const b2::Vec2& v) {
+		lua_pushnumber(L, v.x);
+		lua_pushnumber(L, v.y);
+		vectorsAvoided++;
+		return 2;
+	}
+};
+
+#endif //MEMORYSTATS_H
@@ -0,0 +1,38 @@
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Interns actor names to integer atoms so name buckets are keyed and compared by integer.
+// Atom 0 is never handed out and means the name has not been seen
+class NameTable {
+public:
+	static uint32_t intern(const std::string& name) {
+		if (const auto it = atoms.find(name); it != atoms.end()) {
+			return it->second;
+		}
+		const auto atom = static_cast<uint32_t>(names.size());
+		names.push_back(name);
+		atoms.emplace(name, atom);
+		return atom;
+	}
+
+	// lookups of names no actor ever had don't grow the table
+	static uint32_t find(const std::string& name) {
+		const auto it = atoms.find(name);
+		return it == atoms.end() ? 0 : it->second;
+	}
+
+	static const std::string& name(uint32_t atom) {
+		return names[atom];
+	}
+
+private:
+	static inline std::unordered_map<std::string, uint32_t> atoms;
+	static inline std::vector<std::string> names = {""};
+};
+
+#endif //NAMETABLE_H
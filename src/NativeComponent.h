@@ -0,0 +1,241 @@
+#ifndef NATIVECOMPONENT_H
+#define NATIVECOMPONENT_H
+
+#include <array>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "lua.hpp"
+#include "LuaBridge.h"
+
+#include "scene.hpp"
+#include "serializer.h"
+#include "NativeComponents.h"
+
+// Base for components written in C++. A component lists its fields once and the engine derives
+// scene file loading, lua properties, saving and cloning from that list:
+//
+//     class Spinner : public NativeComponent<Spinner> {
+//     public:
+//         float speed = 90.0f;
+//         static constexpr auto fields() { return std::make_tuple(field("speed", &Spinner::speed)); }
+//         void update();
+//     };
+//     REGISTER_NATIVE_COMPONENT(Spinner)
+//
+// A field can also be a getter and setter pair, field("x", &Transform::getX, &Transform::setX), for values
+// the component keeps outside of itself. Fields can be float, int, bool or std::string. Any of start, update, lateUpdate, destroy,
+// collisionEnter, collisionExit, triggerEnter and triggerExit that the class declares are called
+// like the lua callbacks of the same name. A static bindFunctions(cls) adds lua functions to the class
+
+template <typename C, typename V> struct Field {
+	const char* name;
+	V C::* member;
+};
+
+template <typename C, typename V> struct Accessor {
+	const char* name;
+	V (C::*get)() const;
+	void (C::*set)(V);
+};
+
+template <typename C, typename V> constexpr Field<C, V> field(const char* name, V C::* member) {
+	return {name, member};
+}
+
+template <typename C, typename V> constexpr Accessor<C, V> field(const char* name, V (C::*get)() const, void (C::*set)(V)) {
+	return {name, get, set};
+}
+
+template <typename C, typename V> const V& fieldValue(const C* self, const Field<C, V>& field) { return self->*field.member; }
+template <typename C, typename V> V fieldValue(const C* self, const Accessor<C, V>& field) { return (self->*field.get)(); }
+
+// calls f with the field's value, written back through the setter for accessor fields
+template <typename C, typename V, typename F> void updateField(C* self, const Field<C, V>& field, F&& f) { f(self->*field.member); }
+template <typename C, typename V, typename F> void updateField(C* self, const Accessor<C, V>& field, F&& f) {
+	V value = (self->*field.get)();
+	f(value);
+	(self->*field.set)(value);
+}
+
+template <typename Class, typename C, typename V> void bindField(Class& cls, const Field<C, V>& field) { cls.addProperty(field.name, field.member); }
+template <typename Class, typename C, typename V> void bindField(Class& cls, const Accessor<C, V>& field) { cls.addProperty(field.name, field.get, field.set); }
+
+inline void loadField(float& value, const rapidjson::Value& json) { if (json.IsNumber()) value = json.GetFloat(); }
+inline void loadField(int& value, const rapidjson::Value& json) { if (json.IsInt()) value = json.GetInt(); }
+inline void loadField(bool& value, const rapidjson::Value& json) { if (json.IsBool()) value = json.GetBool(); }
+inline void loadField(std::string& value, const rapidjson::Value& json) { if (json.IsString()) value = json.GetString(); }
+
+inline void loadField(float& value, const PropertyDesc& p) { value = p.asFloat(); }
+inline void loadField(int& value, const PropertyDesc& p) { value = p.asInt(); }
+inline void loadField(bool& value, const PropertyDesc& p) { value = p.boolean; }
+inline void loadField(std::string& value, const PropertyDesc& p) { value = p.string; }
+
+inline void writeField(Serializer& serial, float value) { serial.writeFloat(value); }
+inline void writeField(Serializer& serial, int value) { serial.writeInt(value); }
+inline void writeField(Serializer& serial, bool value) { serial.writeBool(value); }
+inline void writeField(Serializer& serial, const std::string& value) { serial.writeString(value); }
+
+inline void readField(Deserializer& serial, float& value) { value = serial.readFloat(); }
+inline void readField(Deserializer& serial, int& value) { value = serial.readInt(); }
+inline void readField(Deserializer& serial, bool& value) { value = serial.readBool(); }
+inline void readField(Deserializer& serial, std::string& value) { value = serial.readString(); }
+
+template <typename T, typename F> void forEachField(F&& f) {
+	std::apply([&](const auto&... fields) { (f(fields), ...); }, T::fields());
+}
+
+// one loader per field, so a property resolved to its field index is loaded without looking at names
+template <typename T, size_t... I> constexpr auto fieldLoaders(std::index_sequence<I...>) {
+	return std::array<void (*)(T*, const PropertyDesc&), sizeof...(I)>{
+		[](T* self, const PropertyDesc& p) { updateField(self, std::get<I>(T::fields()), [&](auto& value) { loadField(value, p); }); }...};
+}
+
+template <typename T> class NativeComponent : public Component {
+public:
+	Actor* actor = nullptr;
+	std::string key;
+	bool enabled = true;
+
+	// hidden by the derived class to receive the callback
+	void start() {}
+	void update() {}
+	void lateUpdate() {}
+	void destroy() {}
+	void collisionEnter(Collision&) {}
+	void collisionExit(Collision&) {}
+	void triggerEnter(Collision&) {}
+	void triggerExit(Collision&) {}
+	template <typename Class> static void bindFunctions(Class&) {}
+
+	NativeComponent() {
+		type = registration->type;
+		bindCallbacks();
+	}
+
+	NativeComponent(const NativeComponent& other) : Component(), actor(other.actor), key(other.key), enabled(other.enabled) {
+		type = other.type;
+		bindCallbacks();
+	}
+
+	// types that can't be copied, like ones holding a slot somewhere else, are cloned field by field
+	Component* clone() override {
+		T* copy;
+		if constexpr (std::is_copy_constructible_v<T>) copy = new T(static_cast<const T&>(*this));
+		else {
+			copy = new T();
+			copy->actor = actor;
+			copy->key = key;
+			copy->enabled = enabled;
+			const T* self = static_cast<const T*>(this);
+			forEachField<T>([&](const auto& f) {
+				const auto value = fieldValue(self, f);
+				updateField(copy, f, [&](auto& field) { field = value; });
+			});
+		}
+		copy->first = copy;
+		copy->initialized = false;
+		return copy;
+	}
+
+	void serialize(Serializer& serial) override {
+		serial.writeBool(enabled);
+		T* self = static_cast<T*>(this);
+		forEachField<T>([&](const auto& f) { writeField(serial, fieldValue(self, f)); });
+	}
+
+	static NativeType describe(const char* name) {
+		NativeType native;
+		native.name = name;
+		forEachField<T>([&](const auto& f) { native.fields.emplace_back(f.name); });
+		native.create = create;
+		native.loadJson = loadJson;
+		native.loadDesc = loadDesc;
+		native.read = read;
+		native.bind = bind;
+		return native;
+	}
+
+	// set by REGISTER_NATIVE_COMPONENT, the type id inside is assigned by NativeComponents::initialize
+	static inline const NativeType* registration = nullptr;
+
+	// each native component type has its own ObjectPool, named after its registration
+	static void* operator new(size_t size) { return ObjectPool<T>::allocate(size, registration->name.c_str()); }
+	static void operator delete(void* object, size_t size) { ObjectPool<T>::release(object, size); }
+
+private:
+	void bindCallbacks() {
+		using luabridge::LuaRef;
+		if constexpr (!std::is_same_v<decltype(&T::start), void (NativeComponent::*)()>)
+			onStart = [](LuaRef ref) { ref.cast<T*>()->start(); };
+		if constexpr (!std::is_same_v<decltype(&T::update), void (NativeComponent::*)()>)
+			onUpdate = [](LuaRef ref) { ref.cast<T*>()->update(); };
+		if constexpr (!std::is_same_v<decltype(&T::lateUpdate), void (NativeComponent::*)()>)
+			onLateUpdate = [](LuaRef ref) { ref.cast<T*>()->lateUpdate(); };
+		if constexpr (!std::is_same_v<decltype(&T::destroy), void (NativeComponent::*)()>)
+			onDestroyed = [](LuaRef ref) { ref.cast<T*>()->destroy(); };
+		if constexpr (!std::is_same_v<decltype(&T::collisionEnter), void (NativeComponent::*)(Collision&)>)
+			onCollisionEnter = [](LuaRef ref, Collision& col) { ref.cast<T*>()->collisionEnter(col); };
+		if constexpr (!std::is_same_v<decltype(&T::collisionExit), void (NativeComponent::*)(Collision&)>)
+			onCollisionExit = [](LuaRef ref, Collision& col) { ref.cast<T*>()->collisionExit(col); };
+		if constexpr (!std::is_same_v<decltype(&T::triggerEnter), void (NativeComponent::*)(Collision&)>)
+			onTriggerEnter = [](LuaRef ref, Collision& col) { ref.cast<T*>()->triggerEnter(col); };
+		if constexpr (!std::is_same_v<decltype(&T::triggerExit), void (NativeComponent::*)(Collision&)>)
+			onTriggerExit = [](LuaRef ref, Collision& col) { ref.cast<T*>()->triggerExit(col); };
+	}
+
+	static Component* create(Actor* actor, const std::string& key) {
+		T* component = new T();
+		component->first = component;
+		component->actor = actor;
+		component->key = key;
+		component->enabled = true;
+		component->initialized = false;
+		return component;
+	}
+
+	static void loadJson(Component* component, const rapidjson::Value& json) {
+		T* self = static_cast<T*>(component);
+		forEachField<T>([&](const auto& f) {
+			if (const auto it = json.FindMember(f.name); it != json.MemberEnd())
+				updateField(self, f, [&](auto& value) { loadField(value, it->value); });
+		});
+	}
+
+	// property fields were resolved against this type's field table when the desc was read
+	static void loadDesc(Component* component, const ComponentDesc& desc) {
+		static constexpr auto loaders = fieldLoaders<T>(std::make_index_sequence<std::tuple_size_v<decltype(T::fields())>>());
+		T* self = static_cast<T*>(component);
+		for (const PropertyDesc& p : desc.properties) {
+			if (p.field >= 0 && static_cast<size_t>(p.field) < loaders.size()) loaders[p.field](self, p);
+		}
+	}
+
+	static Component* read(Deserializer& serial, Actor* actor) {
+		T* component = new T();
+		component->first = component;
+		component->actor = actor;
+		component->enabled = serial.readBool();
+		forEachField<T>([&](const auto& f) { updateField(component, f, [&](auto& value) { readField(serial, value); }); });
+		return component;
+	}
+
+	static void bind(lua_State* L) {
+		auto cls = luabridge::getGlobalNamespace(L).template beginClass<T>(registration->name.c_str());
+		cls.addProperty("enabled", static_cast<bool T::*>(&T::enabled));
+		cls.addProperty("key", static_cast<std::string T::*>(&T::key));
+		cls.addProperty("actor", static_cast<Actor* T::*>(&T::actor));
+		forEachField<T>([&](const auto& f) { bindField(cls, f); });
+		T::bindFunctions(cls);
+		cls.endClass();
+		Serializer::addToExcludeSet(registration->name);
+	}
+};
+
+// put in the component's .cpp file, the lua and scene file name of the type is the class name
+#define REGISTER_NATIVE_COMPONENT(T) \
+	static const bool T##Registered = (NativeComponent<T>::registration = &NativeComponents::add(NativeComponent<T>::describe(#T)), true);
+
+#endif //NATIVECOMPONENT_H
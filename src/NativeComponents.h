@@ -0,0 +1,65 @@
+#ifndef NATIVECOMPONENTS_H
+#define NATIVECOMPONENTS_H
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "lua.hpp"
+
+#include "ComponentTypes.h"
+#include "SceneDesc.h"
+
+class Actor;
+class Component;
+class Deserializer;
+
+// Everything the engine needs to create, load and save a native component without knowing its class.
+// Filled in from a component's field table by NativeComponent.h, see REGISTER_NATIVE_COMPONENT
+struct NativeType {
+	std::string name;
+	ComponentType type = ComponentTypes::None;
+	// in field table order, PropertyDesc::field indexes into it
+	std::vector<std::string> fields;
+	Component* (*create)(Actor* actor, const std::string& key) = nullptr;
+	void (*loadJson)(Component* component, const rapidjson::Value& json) = nullptr;
+	void (*loadDesc)(Component* component, const ComponentDesc& desc) = nullptr;
+	Component* (*read)(Deserializer& serial, Actor* actor) = nullptr;
+	void (*bind)(lua_State* L) = nullptr;
+};
+
+class NativeComponents {
+public:
+	// called by static registration objects, possibly before main
+	static NativeType& add(const NativeType& type) {
+		nativeFieldNames()[type.name] = type.fields;
+		return pending().emplace_back(type);
+	}
+
+	// gives every registered type its id and lua class, called once lua is up
+	static void initialize(lua_State* L) {
+		for (NativeType& type : pending()) {
+			type.type = ComponentTypes::id(type.name);
+			if (byType.size() <= type.type) byType.resize(type.type + 1, nullptr);
+			byType[type.type] = &type;
+			type.bind(L);
+		}
+	}
+
+	// nullptr for lua types and the built in Rigidbody and ParticleSystem
+	static const NativeType* find(ComponentType type) {
+		return type < byType.size() ? byType[type] : nullptr;
+	}
+
+private:
+	// function local so registration from other translation units can't run before it exists
+	// a deque so the references handed out by add stay valid
+	static std::deque<NativeType>& pending() {
+		static std::deque<NativeType> types;
+		return types;
+	}
+
+	static inline std::vector<const NativeType*> byType;
+};
+
+#endif //NATIVECOMPONENTS_H
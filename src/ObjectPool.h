@@ -0,0 +1,161 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+struct PoolStats {
+	size_t live = 0;
+	size_t capacity = 0;
+	size_t slabs = 0;
+	size_t bytes = 0;
+};
+
+// Every pool that has allocated, so scene teardown and memory stats can reach them without knowing the types
+class ObjectPools {
+public:
+	struct Entry {
+		const char* name;
+		PoolStats (*stats)();
+		void (*trim)();
+	};
+	static inline std::vector<Entry> pools;
+
+	// returns the slabs that no longer hold any object to the system
+	static void trimAll() {
+		for (const Entry& pool : pools) pool.trim();
+	}
+};
+
+// Slab allocator for one class of engine object, so actors and components of a type sit together instead of
+// being spread over the heap. Slabs are aligned to their size, which lets release find an object's slab from
+// its address. Objects never move, freed slots are reused before new ones are taken, and a slab that empties
+// out starts over from its first slot. Actors and components are only created and destroyed on the main
+// thread, so there is no locking
+template <typename T> class ObjectPool {
+	struct Slab {
+		Slab* prevOpen = nullptr;
+		Slab* nextOpen = nullptr;
+		void* freeList = nullptr;
+		uint32_t used = 0;
+		uint32_t bumped = 0;
+		bool open = false;
+	};
+
+	static constexpr size_t align = alignof(T) > alignof(void*) ? alignof(T) : alignof(void*);
+	static constexpr size_t roundUp(size_t size) { return (size + align - 1) / align * align; }
+	static constexpr size_t slotSize = roundUp(sizeof(T) > sizeof(void*) ? sizeof(T) : sizeof(void*));
+	static constexpr size_t headerSize = roundUp(sizeof(Slab));
+	// at least 64KB and 8 objects, as a power of two for the address mask
+	static constexpr size_t slabSize(size_t needed) {
+		size_t size = 64 * 1024;
+		while (size < needed) size <<= 1;
+		return size;
+	}
+	static constexpr size_t slabBytes = slabSize(headerSize + 8 * slotSize);
+	static constexpr uint32_t slotsPerSlab = static_cast<uint32_t>((slabBytes - headerSize) / slotSize);
+
+	static inline std::vector<Slab*> slabs;
+	// slabs with a free slot
+	static inline Slab* openSlabs = nullptr;
+	static inline size_t live = 0;
+	static inline bool registered = false;
+
+	static void linkOpen(Slab* slab) {
+		slab->prevOpen = nullptr;
+		slab->nextOpen = openSlabs;
+		if (openSlabs) openSlabs->prevOpen = slab;
+		openSlabs = slab;
+		slab->open = true;
+	}
+
+	static void unlinkOpen(Slab* slab) {
+		if (slab->prevOpen) slab->prevOpen->nextOpen = slab->nextOpen;
+		else openSlabs = slab->nextOpen;
+		if (slab->nextOpen) slab->nextOpen->prevOpen = slab->prevOpen;
+		slab->prevOpen = nullptr;
+		slab->nextOpen = nullptr;
+		slab->open = false;
+	}
+
+	static Slab* grow(const char* name) {
+		if (!registered) {
+			ObjectPools::pools.push_back({name, stats, trim});
+			registered = true;
+		}
+		void* memory = ::operator new(slabBytes, std::align_val_t(slabBytes));
+		auto* slab = new (memory) Slab();
+		slabs.push_back(slab);
+		linkOpen(slab);
+		return slab;
+	}
+
+public:
+	// objects of a class derived from T that has no pool of its own have a different size and use the heap
+	static void* allocate(size_t size, const char* name) {
+		if (size != sizeof(T)) return ::operator new(size);
+		Slab* slab = openSlabs ? openSlabs : grow(name);
+		void* slot;
+		if (slab->freeList) {
+			slot = slab->freeList;
+			slab->freeList = *static_cast<void**>(slot);
+		}
+		else {
+			slot = reinterpret_cast<std::byte*>(slab) + headerSize + slab->bumped * slotSize;
+			slab->bumped++;
+		}
+		slab->used++;
+		live++;
+		if (slab->used == slotsPerSlab) unlinkOpen(slab);
+		return slot;
+	}
+
+	static void release(void* object, size_t size) {
+		if (!object) return;
+		if (size != sizeof(T)) {
+			::operator delete(object);
+			return;
+		}
+		auto* slab = reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(object) & ~static_cast<uintptr_t>(slabBytes - 1));
+		*static_cast<void**>(object) = slab->freeList;
+		slab->freeList = object;
+		slab->used--;
+		live--;
+		if (slab->used == 0) {
+			slab->freeList = nullptr;
+			slab->bumped = 0;
+		}
+		if (!slab->open) linkOpen(slab);
+	}
+
+	static void trim() {
+		size_t kept = 0;
+		for (Slab* slab : slabs) {
+			if (slab->used == 0) {
+				if (slab->open) unlinkOpen(slab);
+				slab->~Slab();
+				::operator delete(slab, std::align_val_t(slabBytes));
+			}
+			else slabs[kept++] = slab;
+		}
+		slabs.resize(kept);
+	}
+
+	static PoolStats stats() {
+		PoolStats result;
+		result.live = live;
+		result.capacity = slabs.size() * slotsPerSlab;
+		result.slabs = slabs.size();
+		result.bytes = slabs.size() * slabBytes;
+		return result;
+	}
+};
+
+// Gives a class pooled new and delete. Goes in the public part of the class body
+#define POOLED_OBJECT(T) \
+	static void* operator new(size_t size) { return ObjectPool<T>::allocate(size, #T); } \
+	static void operator delete(void* object, size_t size) { ObjectPool<T>::release(object, size); }
+
+#endif //OBJECTPOOL_H
@@ -0,0 +1,503 @@
+#include "ParallelLanes.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "LuaBridge.h"
+
+#include "scene.hpp"
+#include "RigidBody.h"
+#include "EventBus.h"
+#include "luafuncs.h"
+#include "LuaAllocator.h"
+
+using luabridge::LuaRef;
+
+namespace {
+	RigidBody* bodyOf(const Actor* actor) {
+		const auto it = actor->componentsByType.find(ComponentTypes::Rigidbody);
+		if (it == actor->componentsByType.end() || it->second.empty()) return nullptr;
+		auto* rb = static_cast<RigidBody*>(it->second.front());
+		return rb->body ? rb : nullptr;
+	}
+
+	// pushes a copy of the plain value at index of from onto to, nil for anything that can't cross states
+	void pushCopy(lua_State* from, int index, lua_State* to, int depth) {
+		index = lua_absindex(from, index);
+		switch (lua_type(from, index)) {
+			case LUA_TNUMBER:
+				if (lua_isinteger(from, index)) lua_pushinteger(to, lua_tointeger(from, index));
+				else lua_pushnumber(to, lua_tonumber(from, index));
+				break;
+			case LUA_TSTRING: {
+				size_t length;
+				const char* text = lua_tolstring(from, index, &length);
+				lua_pushlstring(to, text, length);
+				break;
+			}
+			case LUA_TBOOLEAN:
+				lua_pushboolean(to, lua_toboolean(from, index));
+				break;
+			case LUA_TTABLE:
+				// plain nested data such as waypoint lists, deep structures are cut off rather than risking cycles
+				if (depth > 8) {
+					lua_pushnil(to);
+					break;
+				}
+				lua_newtable(to);
+				lua_pushnil(from);
+				while (lua_next(from, index)) {
+					pushCopy(from, -2, to, depth + 1);
+					pushCopy(from, -1, to, depth + 1);
+					if (lua_isnil(to, -2) || lua_isnil(to, -1)) lua_pop(to, 2);
+					else lua_rawset(to, -3);
+					lua_pop(from, 1);
+				}
+				break;
+			default:
+				lua_pushnil(to);
+		}
+	}
+
+	void setNumber(lua_State* L, const char* field, double value) {
+		lua_pushnumber(L, value);
+		lua_setfield(L, -2, field);
+	}
+
+	// the fields kept in sync between a main instance and its lane instance. enabled stays the main
+	// instance's, it decides whether the component is scheduled at all, and snapshot is the lane's own
+	bool syncedField(lua_State* L, int key, int value) {
+		const int type = lua_type(L, value);
+		if (lua_type(L, key) != LUA_TSTRING || (type != LUA_TNUMBER && type != LUA_TSTRING && type != LUA_TBOOLEAN)) return false;
+		const char* name = lua_tostring(L, key);
+		return std::strcmp(name, "enabled") != 0 && std::strcmp(name, "snapshot") != 0;
+	}
+
+	// whether two scalars in different states are equal
+	bool sameScalar(lua_State* a, int ia, lua_State* b, int ib) {
+		const int type = lua_type(a, ia);
+		if (type != lua_type(b, ib)) return false;
+		switch (type) {
+			case LUA_TNUMBER:
+				if (lua_isinteger(a, ia) != lua_isinteger(b, ib)) return false;
+				return lua_isinteger(a, ia) ? lua_tointeger(a, ia) == lua_tointeger(b, ib) : lua_tonumber(a, ia) == lua_tonumber(b, ib);
+			case LUA_TSTRING: {
+				size_t lengthA, lengthB;
+				const char* textA = lua_tolstring(a, ia, &lengthA);
+				const char* textB = lua_tolstring(b, ib, &lengthB);
+				return lengthA == lengthB && std::memcmp(textA, textB, lengthA) == 0;
+			}
+			case LUA_TBOOLEAN:
+				return lua_toboolean(a, ia) == lua_toboolean(b, ib);
+			default:
+				return false;
+		}
+	}
+}
+
+void ParallelLanes::initialize(int count) {
+	if (count <= 1) return;
+	lanes.resize(count);
+	for (Lane& lane : lanes) {
+		lane.L = LuaAllocator::newState();
+		luaL_openlibs(lane.L);
+		static const luaL_Reg functions[] = {
+			{"SetVelocity", setVelocity},
+			{"SetPosition", setPosition},
+			{"AddForce", addForce},
+			{"Publish", publish},
+			{"Destroy", destroy},
+			{"Instantiate", instantiate},
+			{nullptr, nullptr}
+		};
+		lua_newtable(lane.L);
+		lua_pushlightuserdata(lane.L, &lane);
+		luaL_setfuncs(lane.L, functions, 1);
+		lua_setglobal(lane.L, "Lane");
+	}
+	sync = new Sync();
+	for (size_t i = 1; i < lanes.size(); i++) {
+		std::thread(work, i).detach();
+	}
+}
+
+void ParallelLanes::loadType(lua_State* L, const ScriptCache::Script& script) {
+	if (!enabled()) return;
+	const std::string type = script.path.stem().string();
+	const int top = lua_gettop(L);
+	lua_getglobal(L, type.c_str());
+	const bool parallel = lua_istable(L, -1) && lua_getfield(L, -1, "parallel") != LUA_TNIL && lua_toboolean(L, -1);
+	lua_settop(L, top);
+	if (!parallel) return;
+	for (Lane& lane : lanes) {
+		if (ScriptCache::load(lane.L, script) != LUA_OK || lua_pcall(lane.L, 0, 0, 0) != LUA_OK) {
+			std::cout << "problem with lua file " << type;
+			exit(0);
+		}
+	}
+}
+
+void ParallelLanes::schedule(Actor* actor, Component* component) {
+	auto it = instances.find(component);
+	if (it == instances.end()) {
+		// spread instances over the lanes as they first update, each then stays on its lane
+		it = instances.emplace(component, Instance{nextLane, LUA_NOREF, LUA_NOREF}).first;
+		nextLane = (nextLane + 1) % static_cast<int>(lanes.size());
+	}
+	lanes[it->second.lane].items.push_back({actor, component, it->second.ref, it->second.synced});
+}
+
+void ParallelLanes::release(Component* component) {
+	const auto it = instances.find(component);
+	if (it == instances.end()) return;
+	luaL_unref(lanes[it->second.lane].L, LUA_REGISTRYINDEX, it->second.ref);
+	luaL_unref(lanes[it->second.lane].L, LUA_REGISTRYINDEX, it->second.synced);
+	instances.erase(it);
+}
+
+void ParallelLanes::prepare(Lane& lane, Item& item) {
+	lua_State* L = lane.L;
+	if (item.ref == LUA_NOREF) seed(L, item);
+	else pushChanges(L, item);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, item.ref);
+	if (lua_getfield(L, -1, "snapshot") != LUA_TTABLE) {
+		lua_pop(L, 1);
+		lua_newtable(L);
+		lua_pushvalue(L, -1);
+		lua_setfield(L, -3, "snapshot");
+	}
+	b2::Vec2 position;
+	const bool hasPosition = item.actor->findPosition(position);
+	lua_pushboolean(L, hasPosition);
+	lua_setfield(L, -2, "has_position");
+	setNumber(L, "x", position.x);
+	setNumber(L, "y", position.y);
+	const RigidBody* rb = bodyOf(item.actor);
+	const b2::Vec2 velocity = rb ? rb->getVelocity() : b2::Vec2(0.0f, 0.0f);
+	setNumber(L, "vx", velocity.x);
+	setNumber(L, "vy", velocity.y);
+	setNumber(L, "rotation", rb ? rb->getRotation() : 0.0f);
+	// read through the type table, so a type can set it for all of its instances
+	lua_State* main = item.component->first.state();
+	item.component->first.push();
+	lua_getfield(main, -1, "nearby_radius");
+	const auto radius = static_cast<float>(lua_tonumber(main, -1));
+	lua_pop(main, 2);
+	if (hasPosition && radius > 0.0f) snapshotNearby(L, item, position.x, position.y, radius);
+	else {
+		lua_pushnil(L);
+		lua_setfield(L, -2, "nearby");
+	}
+	lua_settop(L, 0);
+}
+
+void ParallelLanes::seed(lua_State* L, Item& item) {
+	// from the main instance as OnStart left it
+	lua_State* main = item.component->first.state();
+	item.component->first.push();
+	pushCopy(main, -1, L, 0);
+	lua_pop(main, 1);
+	lua_newtable(L);
+	lua_getglobal(L, ComponentTypes::name(item.component->type).c_str());
+	lua_setfield(L, -2, "__index");
+	lua_setmetatable(L, -2);
+	lua_newtable(L);
+	lua_pushnil(L);
+	while (lua_next(L, -3)) {
+		if (syncedField(L, -2, -1)) {
+			lua_pushvalue(L, -2);
+			lua_insert(L, -2);
+			lua_rawset(L, -4);
+		}
+		else lua_pop(L, 1);
+	}
+	item.synced = luaL_ref(L, LUA_REGISTRYINDEX);
+	item.ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	Instance& instance = instances[item.component];
+	instance.ref = item.ref;
+	instance.synced = item.synced;
+}
+
+void ParallelLanes::pushChanges(lua_State* L, const Item& item) {
+	lua_State* main = item.component->first.state();
+	item.component->first.push();
+	const int source = lua_gettop(main);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, item.ref);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, item.synced);
+	lua_pushnil(main);
+	while (lua_next(main, source)) {
+		if (syncedField(main, -2, -1)) {
+			pushCopy(main, -2, L, 0);
+			lua_pushvalue(L, -1);
+			lua_rawget(L, -3);
+			const bool same = sameScalar(main, -1, L, -1);
+			lua_pop(L, 1);
+			if (!same) {
+				pushCopy(main, -1, L, 0);
+				lua_pushvalue(L, -2);
+				lua_pushvalue(L, -2);
+				lua_rawset(L, -6);
+				lua_rawset(L, -3);
+			}
+			else lua_pop(L, 1);
+		}
+		lua_pop(main, 1);
+	}
+	// fields the main side cleared
+	lua_pushnil(L);
+	while (lua_next(L, -2)) {
+		lua_pop(L, 1);
+		pushCopy(L, -1, main, 0);
+		lua_rawget(main, source);
+		const int type = lua_type(main, -1);
+		lua_pop(main, 1);
+		if (type != LUA_TNUMBER && type != LUA_TSTRING && type != LUA_TBOOLEAN) {
+			lua_pushvalue(L, -1);
+			lua_pushnil(L);
+			lua_rawset(L, -4);
+			lua_pushvalue(L, -1);
+			lua_pushnil(L);
+			lua_rawset(L, -5);
+		}
+	}
+	lua_settop(L, 0);
+	lua_settop(main, source - 1);
+}
+
+void ParallelLanes::snapshotNearby(lua_State* L, const Item& item, float x, float y, float radius) {
+	nearby.clear();
+	Scene::globalSceneRef->spatial.queryRadius(x, y, radius, nearby);
+	// the list and its entries are reused from the last frame, so a steady neighbourhood makes no garbage
+	if (lua_getfield(L, -1, "nearby") != LUA_TTABLE) {
+		lua_pop(L, 1);
+		lua_createtable(L, static_cast<int>(nearby.size()), 0);
+		lua_pushvalue(L, -1);
+		lua_setfield(L, -3, "nearby");
+	}
+	lua_Integer count = 0;
+	for (const Actor* other : nearby) {
+		if (other == item.actor) continue;
+		count++;
+		if (lua_rawgeti(L, -1, count) != LUA_TTABLE) {
+			lua_pop(L, 1);
+			lua_createtable(L, 0, 6);
+			lua_pushvalue(L, -1);
+			lua_rawseti(L, -3, count);
+		}
+		b2::Vec2 position;
+		other->findPosition(position);
+		const RigidBody* rb = bodyOf(other);
+		const b2::Vec2 velocity = rb ? rb->getVelocity() : b2::Vec2(0.0f, 0.0f);
+		lua_pushinteger(L, static_cast<lua_Integer>(other->uuid));
+		lua_setfield(L, -2, "id");
+		lua_pushlstring(L, other->name.data(), other->name.size());
+		lua_setfield(L, -2, "name");
+		setNumber(L, "x", position.x);
+		setNumber(L, "y", position.y);
+		setNumber(L, "vx", velocity.x);
+		setNumber(L, "vy", velocity.y);
+		lua_pop(L, 1);
+	}
+	for (lua_Integer i = count + 1; lua_rawgeti(L, -1, i) != LUA_TNIL; i++) {
+		lua_pop(L, 1);
+		lua_pushnil(L);
+		lua_rawseti(L, -2, i);
+	}
+	lua_pop(L, 2);
+}
+
+void ParallelLanes::run(Lane& lane) {
+	lua_State* L = lane.L;
+	for (lane.current = 0; lane.current < lane.items.size(); lane.current++) {
+		lua_rawgeti(L, LUA_REGISTRYINDEX, lane.items[lane.current].ref);
+		if (lua_getfield(L, -1, "OnUpdate") == LUA_TFUNCTION) {
+			lua_pushvalue(L, -2);
+			if (lua_pcall(L, 1, 0, 0) != LUA_OK) {
+				const char* message = lua_tostring(L, -1);
+				lane.errors.push_back(lane.items[lane.current].actor->name + " : " + (message ? message : "error in parallel OnUpdate"));
+			}
+		}
+		lua_settop(L, 0);
+	}
+}
+
+void ParallelLanes::work(size_t lane) {
+	uint64_t seen = 0;
+	std::unique_lock lock(sync->mutex);
+	while (true) {
+		sync->start.wait(lock, [&seen] { return sync->generation != seen; });
+		seen = sync->generation;
+		lock.unlock();
+		run(lanes[lane]);
+		lock.lock();
+		if (--sync->pending == 0) sync->done.notify_one();
+	}
+}
+
+void ParallelLanes::update() {
+	if (!enabled()) return;
+	for (Lane& lane : lanes) {
+		for (Item& item : lane.items) prepare(lane, item);
+	}
+	{
+		std::lock_guard lock(sync->mutex);
+		sync->generation++;
+		sync->pending = lanes.size() - 1;
+	}
+	sync->start.notify_all();
+	run(lanes[0]);
+	{
+		std::unique_lock lock(sync->mutex);
+		sync->done.wait(lock, [] { return sync->pending == 0; });
+	}
+	// in lane order so the result doesn't depend on which worker finished first
+	for (Lane& lane : lanes) finish(lane);
+}
+
+void ParallelLanes::finish(Lane& lane) {
+	lua_State* L = lane.L;
+	for (const std::string& error : lane.errors) {
+		std::cout << "\033[31m" << error << "\033[0m" << std::endl;
+	}
+	for (const Item& item : lane.items) pullChanges(L, item);
+	for (const Command& command : lane.commands) apply(command);
+	lane.items.clear();
+	lane.commands.clear();
+	lane.errors.clear();
+}
+
+void ParallelLanes::pullChanges(lua_State* L, const Item& item) {
+	lua_State* main = item.component->first.state();
+	item.component->first.push();
+	const int target = lua_gettop(main);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, item.ref);
+	lua_rawgeti(L, LUA_REGISTRYINDEX, item.synced);
+	lua_pushnil(L);
+	while (lua_next(L, -3)) {
+		if (syncedField(L, -2, -1)) {
+			lua_pushvalue(L, -2);
+			lua_rawget(L, -4);
+			const bool same = lua_rawequal(L, -1, -2);
+			lua_pop(L, 1);
+			if (!same) {
+				pushCopy(L, -2, main, 0);
+				pushCopy(L, -1, main, 0);
+				lua_settable(main, target);
+				lua_pushvalue(L, -2);
+				lua_insert(L, -2);
+				lua_rawset(L, -4);
+				continue;
+			}
+		}
+		lua_pop(L, 1);
+	}
+	// fields the lane cleared
+	lua_pushnil(L);
+	while (lua_next(L, -2)) {
+		lua_pop(L, 1);
+		lua_pushvalue(L, -1);
+		const int type = lua_rawget(L, -4);
+		lua_pop(L, 1);
+		if (type != LUA_TNUMBER && type != LUA_TSTRING && type != LUA_TBOOLEAN) {
+			pushCopy(L, -1, main, 0);
+			lua_pushnil(main);
+			lua_settable(main, target);
+			lua_pushvalue(L, -1);
+			lua_pushnil(L);
+			lua_rawset(L, -4);
+		}
+	}
+	lua_settop(L, 0);
+	lua_settop(main, target - 1);
+}
+
+void ParallelLanes::apply(const Command& command) {
+	std::vector<Actor*>& removed = Scene::globalSceneRef->removedThisFrame;
+	if (std::find(removed.begin(), removed.end(), command.actor) != removed.end()) return;
+	switch (command.type) {
+		case CommandType::SetVelocity:
+			if (const RigidBody* rb = bodyOf(command.actor)) rb->setVelocity({command.x, command.y});
+			break;
+		case CommandType::SetPosition:
+			if (RigidBody* rb = bodyOf(command.actor)) rb->setPosition({command.x, command.y});
+			else command.actor->setPosition({command.x, command.y});
+			break;
+		case CommandType::AddForce:
+			if (const RigidBody* rb = bodyOf(command.actor)) rb->AddForce({command.x, command.y});
+			break;
+		case CommandType::Publish: {
+			LuaRef payload(luaState);
+			if (command.valueType == LUA_TNUMBER) payload = command.number;
+			else if (command.valueType == LUA_TSTRING) payload = command.string;
+			else if (command.valueType == LUA_TBOOLEAN) payload = command.number != 0.0;
+			Events::publish(LuaRef(luaState, command.text), payload);
+			break;
+		}
+		case CommandType::Destroy:
+			Scene::destroyActor(command.actor);
+			break;
+		case CommandType::Instantiate:
+			Scene::createActor(command.text);
+			break;
+	}
+}
+
+ParallelLanes::Lane& ParallelLanes::laneOf(lua_State* L) {
+	return *static_cast<Lane*>(lua_touserdata(L, lua_upvalueindex(1)));
+}
+
+int ParallelLanes::queue(lua_State* L, CommandType type) {
+	Lane& lane = laneOf(L);
+	if (lane.current >= lane.items.size()) return luaL_error(L, "Lane functions can only be called from OnUpdate");
+	Command command{type, lane.items[lane.current].actor};
+	switch (type) {
+		case CommandType::SetVelocity:
+		case CommandType::SetPosition:
+		case CommandType::AddForce:
+			command.x = static_cast<float>(luaL_checknumber(L, 1));
+			command.y = static_cast<float>(luaL_checknumber(L, 2));
+			break;
+		case CommandType::Publish:
+			command.text = luaL_checkstring(L, 1);
+			command.valueType = lua_type(L, 2);
+			if (command.valueType == LUA_TNUMBER) command.number = lua_tonumber(L, 2);
+			else if (command.valueType == LUA_TSTRING) command.string = lua_tostring(L, 2);
+			else if (command.valueType == LUA_TBOOLEAN) command.number = lua_toboolean(L, 2);
+			else if (command.valueType != LUA_TNIL && command.valueType != LUA_TNONE) {
+				return luaL_argerror(L, 2, "Lane.Publish payloads must be a number, string or boolean");
+			}
+			break;
+		case CommandType::Instantiate:
+			command.text = luaL_checkstring(L, 1);
+			break;
+		case CommandType::Destroy:
+			break;
+	}
+	lane.commands.push_back(std::move(command));
+	return 0;
+}
+
+int ParallelLanes::setVelocity(lua_State* L) {
+	return queue(L, CommandType::SetVelocity);
+}
+
+int ParallelLanes::setPosition(lua_State* L) {
+	return queue(L, CommandType::SetPosition);
+}
+
+int ParallelLanes::addForce(lua_State* L) {
+	return queue(L, CommandType::AddForce);
+}
+
+int ParallelLanes::publish(lua_State* L) {
+	return queue(L, CommandType::Publish);
+}
+
+int ParallelLanes::destroy(lua_State* L) {
+	return queue(L, CommandType::Destroy);
+}
+
+int ParallelLanes::instantiate(lua_State* L) {
+	return queue(L, CommandType::Instantiate);
+}
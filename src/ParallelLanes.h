@@ -0,0 +1,112 @@
+#ifndef PARALLELLANES_H
+#define PARALLELLANES_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "lua.hpp"
+
+#include "ScriptCache.h"
+
+class Actor;
+class Component;
+
+// Runs OnUpdate of component types that declare parallel = true in worker lua states, one per lane, at the
+// same time. Each instance belongs to one lane and keeps its fields in that lane's state, seeded from the
+// main instance. Scalar fields changed on either side since the last frame are copied to the other, main
+// side changes before the update and lane changes after it. Lane scripts can't reach the engine, they read
+// self.snapshot and queue commands with the Lane functions, which are applied on the main thread afterwards
+class ParallelLanes {
+public:
+	// count lanes including the main thread's, 0 or 1 runs parallel types like any other
+	static void initialize(int count);
+	[[nodiscard]] static bool enabled() { return lanes.size() > 1; }
+	// runs a component type's file in every lane if it is a parallel type, after it ran in L
+	static void loadType(lua_State* L, const ScriptCache::Script& script);
+	// queues a component's OnUpdate for this frame's run
+	static void schedule(Actor* actor, Component* component);
+	// runs every queued update, then copies fields back and applies the lanes' commands
+	static void update();
+	// drops a destroyed component's lane instance
+	static void release(Component* component);
+
+private:
+	struct Item {
+		Actor* actor;
+		Component* component;
+		int ref;
+		int synced;
+	};
+
+	enum class CommandType : uint8_t { SetVelocity, SetPosition, AddForce, Publish, Destroy, Instantiate };
+
+	struct Command {
+		CommandType type;
+		Actor* actor;
+		float x = 0.0f, y = 0.0f;
+		std::string text;
+		// payload of Publish, number, string, boolean or nil
+		int valueType = LUA_TNIL;
+		double number = 0.0;
+		std::string string;
+	};
+
+	struct Lane {
+		lua_State* L = nullptr;
+		std::vector<Item> items;
+		std::vector<Command> commands;
+		std::vector<std::string> errors;
+		// item whose OnUpdate is running, for the Lane functions
+		size_t current = 0;
+	};
+
+	struct Instance {
+		int lane;
+		int ref;
+		// lane registry table of the scalar fields as both sides last agreed on them
+		int synced;
+	};
+
+	// lanes[0] runs on the main thread, worker i runs lanes[i]
+	static inline std::vector<Lane> lanes;
+	static inline std::unordered_map<Component*, Instance> instances;
+	static inline int nextLane = 0;
+	static inline std::vector<Actor*> nearby;
+
+	// never freed, detached workers may still wait on them while the program exits
+	struct Sync {
+		std::mutex mutex;
+		std::condition_variable start, done;
+		uint64_t generation = 0;
+		size_t pending = 0;
+	};
+	static inline Sync* sync = nullptr;
+
+	static void work(size_t lane);
+	static void run(Lane& lane);
+	static void prepare(Lane& lane, Item& item);
+	static void seed(lua_State* L, Item& item);
+	// copies the scalar fields the main instance changed since the last sync into the lane instance
+	static void pushChanges(lua_State* L, const Item& item);
+	// copies the scalar fields the lane changed during its update back to the main instance
+	static void pullChanges(lua_State* L, const Item& item);
+	static void snapshotNearby(lua_State* L, const Item& item, float x, float y, float radius);
+	static void finish(Lane& lane);
+	static void apply(const Command& command);
+	static Lane& laneOf(lua_State* L);
+	static int queue(lua_State* L, CommandType type);
+
+	static int setVelocity(lua_State* L);
+	static int setPosition(lua_State* L);
+	static int addForce(lua_State* L);
+	static int publish(lua_State* L);
+	static int destroy(lua_State* L);
+	static int instantiate(lua_State* L);
+};
+
+#endif //PARALLELLANES_H
@@ -6,6 +6,7 @@
 
 #include "Rendering.h"
 #include "serializer.h"
+#include "SceneDesc.h"
 
 using namespace luabridge;
 
@@ -367,7 +368,7 @@ ParticleSystem::ParticleSystem(): lifetimePerFrame(0), lifetime1(0) {
     actor = nullptr;
     onStart = &onStartFunc;
     onUpdate = &onUpdateFunc;
-    this->type = "ParticleSystem";
+    this->type = ComponentTypes::ParticleSystem;
 }
 
 ParticleSystem::ParticleSystem(rapidjson::Value &json) : ParticleSystem() {
@@ -474,6 +475,46 @@ ParticleSystem::ParticleSystem(rapidjson::Value &json) : ParticleSystem() {
     }
 }
 
+void ParticleSystem::applyDesc(const ComponentDesc &desc) {
+    for (const PropertyDesc& p : desc.properties) {
+        switch (p.field) {
+            case PS_X: startPos.x = p.asFloat(); break;
+            case PS_Y: startPos.y = p.asFloat(); break;
+            case PS_FRAMES_BETWEEN_BURSTS: framesBetweenBursts = p.asInt(); break;
+            case PS_BURST_QUANTITY: burstQuantity = p.asInt(); break;
+            case PS_ROTATION_MIN: rotationRange.x = p.asFloat(); break;
+            case PS_ROTATION_MAX: rotationRange.y = p.asFloat(); break;
+            case PS_START_SCALE_MIN: startScale.x = p.asFloat(); break;
+            case PS_START_SCALE_MAX: startScale.y = p.asFloat(); break;
+            case PS_START_COLOR_R: startColor.r = p.asInt(); break;
+            case PS_START_COLOR_G: startColor.g = p.asInt(); break;
+            case PS_START_COLOR_B: startColor.b = p.asInt(); break;
+            case PS_START_COLOR_A: startColor.a = p.asInt(); break;
+            case PS_END_COLOR_R: setEndR(p.asInt()); break;
+            case PS_END_COLOR_G: setEndG(p.asInt()); break;
+            case PS_END_COLOR_B: setEndB(p.asInt()); break;
+            case PS_END_COLOR_A: setEndA(p.asInt()); break;
+            case PS_EMIT_RADIUS_MIN: emitRadiusRange.x = p.asFloat(); break;
+            case PS_EMIT_RADIUS_MAX: emitRadiusRange.y = p.asFloat(); break;
+            case PS_EMIT_ANGLE_MIN: emitAngleRange.x = p.asFloat(); break;
+            case PS_EMIT_ANGLE_MAX: emitAngleRange.y = p.asFloat(); break;
+            case PS_IMAGE: image = p.string; break;
+            case PS_SORTING_ORDER: sortingOrder = p.asInt(); break;
+            case PS_DURATION_FRAMES: durationFrames = p.asInt(); break;
+            case PS_START_SPEED_MIN: startSpeed.x = p.asFloat(); break;
+            case PS_START_SPEED_MAX: startSpeed.y = p.asFloat(); break;
+            case PS_ROTATION_SPEED_MIN: rotationSpeed.x = p.asFloat(); break;
+            case PS_ROTATION_SPEED_MAX: rotationSpeed.y = p.asFloat(); break;
+            case PS_GRAVITY_SCALE_X: accel.x = p.asFloat(); break;
+            case PS_GRAVITY_SCALE_Y: accel.y = p.asFloat(); break;
+            case PS_DRAG_FACTOR: dragFactor = p.asFloat(); break;
+            case PS_ANGULAR_DRAG_FACTOR: angularDragFactor = p.asFloat(); break;
+            case PS_END_SCALE: endScale = p.asFloat(); break;
+            default: break;
+        }
+    }
+}
+
 ParticleSystem::ParticleSystem(Deserializer &serial) : ParticleSystem() {
     playing = serial.readBool();
     enabled = serial.readBool();
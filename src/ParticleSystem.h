@@ -29,7 +29,7 @@ public:
     RandomEngine rotSpeedDist;
     std::string key;
     std::string image;
-    SDL_Texture* texture = nullptr;
+    TextureId texture = 0;
     Actor* actor;
     glm::vec2 startPos = {0.0f, 0.0f};
     glm::vec2 startSpeed = {0.0f, 0.0f};
@@ -89,9 +89,12 @@ public:
 
     explicit ParticleSystem(Deserializer & serial);
 
+    void applyDesc(const ComponentDesc& desc);
+
     void serialize(Serializer &serial) override;
 
     Component* clone() override;
+    POOLED_OBJECT(ParticleSystem)
 };
 
 
@@ -11,6 +11,7 @@
 #include "SDL_ttf.h"
 #include "scene.hpp"
 #include "ImageLoader.h"
+#include "AssetRef.h"
 
 namespace std {
     template<> struct hash<pair<string, int>> {
@@ -35,59 +36,83 @@ struct colorEqual {
     }
 };
 
-inline std::unordered_map<std::pair<std::string, SDL_Color>, SDL_Texture*, std::hash<std::pair<std::string, SDL_Color>>, colorEqual> textCache;
+inline std::unordered_map<std::pair<std::string, SDL_Color>, TextureId, std::hash<std::pair<std::string, SDL_Color>>, colorEqual> textCache;
 inline std::unordered_map<std::pair<std::string, int>, TTF_Font*> fontCache;
 
 extern SDL_Renderer* renderer;
 
-inline void drawText(const std::string &text, const int x, const int y, const std::string& font_name, int fontSize, float r, float g, float b, float a) {
-    SDL_Texture *texture;
-    TTF_Font* font;
+inline TTF_Font* getFont(const std::string& font_name, int fontSize) {
     if (const auto it = fontCache.find({ font_name, fontSize }); it != fontCache.end()) {
-        font = it->second;
+        return it->second;
+    }
+    TTF_Font* font = TTF_OpenFont(("resources/fonts/" + font_name + ".ttf").c_str(), fontSize);
+    if (font == nullptr) {
+        std::cout << "error: font " + font_name + " missing";
+        exit(0);
+    }
+    fontCache[{font_name, fontSize}] = font;
+    return font;
+}
+
+// fonts by the id Text.LoadFont returned for them
+inline std::vector<TTF_Font*> fonts;
+inline std::unordered_map<std::pair<std::string, int>, int> fontIds;
+
+inline int loadFont(const std::string& font_name, int fontSize) {
+    if (const auto it = fontIds.find({ font_name, fontSize }); it != fontIds.end()) {
+        return it->second;
     }
+    const int id = static_cast<int>(fonts.size());
+    fonts.push_back(getFont(font_name, fontSize));
+    fontIds[{font_name, fontSize}] = id;
+    return id;
+}
+
+// font is a name, or an id from Text.LoadFont which already has its size
+inline void drawText(const std::string &text, const int x, const int y, const AssetRef& font_ref, int fontSize, float r, float g, float b, float a) {
+    TextureId texture;
+    TTF_Font* font;
+    if (font_ref.id < 0) font = getFont(font_ref.name, fontSize);
+    else if (font_ref.id < static_cast<int>(fonts.size())) font = fonts[font_ref.id];
     else {
-        font = TTF_OpenFont(("resources/fonts/" + font_name + ".ttf").c_str(), fontSize);
-        if (font == nullptr) {
-            std::cout << "error: font " + font_name + " missing";
-            exit(0);
-        }
-        fontCache[{font_name, fontSize}] = font;
+        std::cout << "error: invalid font id " << font_ref.id;
+        exit(0);
     }
     SDL_Color color = { (uint8_t)r,  (uint8_t)g,  (uint8_t)b,  (uint8_t)a };
     if (const auto it = textCache.find({ text , color}); it != textCache.end()) {
         texture = it->second;
     } else {
         SDL_Surface *surface = TTF_RenderUTF8_Solid(font, text.c_str(), color);
-        texture = SDL_CreateTextureFromSurface(renderer, surface);
+        texture = TextureRegistry::add(SDL_CreateTextureFromSurface(renderer, surface));
         textCache[{text, color}] = texture;
     }
     Scene::globalSceneRef->textRenderQueue.push_back({texture, x, y});
 }
 
-inline void drawUI(const std::string& image_name, int x, int y) {
-    SDL_Texture* texture = getImage(renderer, image_name);
+// image_name is a name, or an id from Image.Load
+inline void drawUI(const AssetRef& image_name, int x, int y) {
+    const TextureId texture = getImage(renderer, image_name);
     // find texture if it exists, load it if not
     Scene::globalSceneRef->UIRenderQueue.emplace_back(texture, x, y);
 }
 
-inline void drawUIEx(const std::string& image_name, float x, float y, float r, float g, float b, float a, int order) {
-    SDL_Texture* texture = getImage(renderer, image_name);
+inline void drawUIEx(const AssetRef& image_name, float x, float y, float r, float g, float b, float a, int order) {
+    const TextureId texture = getImage(renderer, image_name);
     Scene::globalSceneRef->UIRenderQueue.emplace_back(texture, x, y, 1.0f, 1.0f, 0, 1.0f, 1.0f, order, (uint8_t) r, (uint8_t)g, (uint8_t)b, (uint8_t)a);
 }
 
-inline void drawImage(const std::string& image_name, float x, float y) {
-    SDL_Texture* texture = getImage(renderer, image_name);
+inline void drawImage(const AssetRef& image_name, float x, float y) {
+    const TextureId texture = getImage(renderer, image_name);
     // find texture if it exists, load it if not
     Scene::globalSceneRef->renderQueue.emplace_back(texture, x, y);
 }
 
-inline void drawImageEx(const std::string& image_name, float x, float y, float rotation, float scaleX, float scaleY, float pivotX, float pivotY, float r, float g, float b, float a, int order) {
-    SDL_Texture* texture = getImage(renderer, image_name);
+inline void drawImageEx(const AssetRef& image_name, float x, float y, float rotation, float scaleX, float scaleY, float pivotX, float pivotY, float r, float g, float b, float a, int order) {
+    const TextureId texture = getImage(renderer, image_name);
     Scene::globalSceneRef->renderQueue.emplace_back(texture, x, y, scaleX, scaleY, rotation, pivotX, pivotY, order, (uint8_t)r, (uint8_t)g, (uint8_t)b, (uint8_t)a);
 }
 
-inline void drawParticle(SDL_Texture* texture, float x, float y, float rotation, float scale, uint8_t r, uint8_t g, uint8_t b, uint8_t a, int order) {
+inline void drawParticle(TextureId texture, float x, float y, float rotation, float scale, uint8_t r, uint8_t g, uint8_t b, uint8_t a, int order) {
     Scene::globalSceneRef->renderQueue.emplace_back(texture, x, y, scale, scale, rotation, 0.5f, 0.5f, order, r, g, b, a);
 }
 
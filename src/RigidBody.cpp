@@ -4,9 +4,14 @@
 
 #include "RigidBody.h"
 
+#include <algorithm>
+
 #include "lua.hpp"
 #include "LuaBridge.h"
 #include "serializer.h"
+#include "SceneDesc.h"
+#include "MemoryStats.h"
+#include "SpatialIndex.h"
 #include "Box2D/Collision/Collision.hpp"
 
 using namespace luabridge;
@@ -35,6 +40,7 @@ void onStartFun(LuaRef ref) {
 	else if (rb->bodyType == "static") def.type = b2::staticBody;
 	else def.type = b2::kinematicBody;
 
+	if (!rb->body) RigidBody::simulated.push_back(rb);
 	rb->body = RigidBody::world->CreateBody(&def);
 	if (rb->has_collider) {
 		b2::FixtureDef fixture;
@@ -137,6 +143,34 @@ RigidBody::RigidBody(Deserializer &serial, Actor* act) {
 	}
 }
 
+void RigidBody::applyDesc(const ComponentDesc &desc) {
+	for (const PropertyDesc& p : desc.properties) {
+		switch (p.field) {
+			case RB_X: x = p.asFloat(); break;
+			case RB_Y: y = p.asFloat(); break;
+			case RB_DENSITY: density = p.asFloat(); break;
+			case RB_ANGULAR_FRICTION: angularDampening = p.asFloat(); break;
+			case RB_GRAVITY_SCALE: gravityScale = p.asFloat(); break;
+			case RB_ROTATION: rotation = p.asFloat(); break;
+			case RB_BODY_TYPE: bodyType = p.string; break;
+			case RB_HAS_COLLIDER: has_collider = p.boolean; break;
+			case RB_HAS_TRIGGER: has_trigger = p.boolean; break;
+			case RB_PRECISE: precise = p.boolean; break;
+			case RB_WIDTH: width = p.asFloat(); break;
+			case RB_HEIGHT: height = p.asFloat(); break;
+			case RB_RADIUS: radius = p.asFloat(); break;
+			case RB_FRICTION: friction = p.asFloat(); break;
+			case RB_BOUNCINESS: bounciness = p.asFloat(); break;
+			case RB_COLLIDER_TYPE: colliderType = p.string; break;
+			case RB_TRIGGER_TYPE: triggerType = p.string; break;
+			case RB_TRIGGER_WIDTH: triggerWidth = p.asFloat(); break;
+			case RB_TRIGGER_HEIGHT: triggerHeight = p.asFloat(); break;
+			case RB_TRIGGER_RADIUS: triggerRadius = p.asFloat(); break;
+			default: break;
+		}
+	}
+}
+
 void RigidBody::serialize(Serializer &serial) {
 	serial.writeBool(enabled);
 	serial.writeFloat(getPosition().x);
@@ -184,6 +218,7 @@ void RigidBody::setPosition(b2::Vec2 vec) {
 		x = vec.x;
 		y = vec.y;
 	} else body->SetTransform(vec, body->GetAngle());
+	SpatialIndex::markMoved(actor);
 }
 
 void RigidBody::setRotation(float degrees) {
@@ -251,8 +286,50 @@ b2::Vec2 RigidBody::getRightDirection() const {
 	return result;
 }
 
+int RigidBody::getPositionXY(lua_State* L) {
+	return MemoryStats::pushXY(L, getPosition());
+}
+
+int RigidBody::getVelocityXY(lua_State* L) {
+	return MemoryStats::pushXY(L, getVelocity());
+}
+
+int RigidBody::getUpDirectionXY(lua_State* L) {
+	return MemoryStats::pushXY(L, getUpDirection());
+}
+
+int RigidBody::getRightDirectionXY(lua_State* L) {
+	return MemoryStats::pushXY(L, getRightDirection());
+}
+
+void RigidBody::setPositionXY(float newX, float newY) {
+	setPosition({newX, newY});
+	MemoryStats::vectorsAvoided++;
+}
+
+void RigidBody::setVelocityXY(float newX, float newY) const {
+	setVelocity({newX, newY});
+	MemoryStats::vectorsAvoided++;
+}
+
+void RigidBody::addForceXY(float forceX, float forceY) const {
+	AddForce({forceX, forceY});
+	MemoryStats::vectorsAvoided++;
+}
+
+void RigidBody::markAwakeMoved() {
+	for (const RigidBody* rb : simulated) {
+		if (rb->body->IsAwake()) SpatialIndex::markMoved(rb->actor);
+	}
+}
+
 RigidBody::~RigidBody() {
-	if (body) world->DestroyBody(body);
+	if (body) {
+		world->DestroyBody(body);
+		const auto it = std::find(simulated.begin(), simulated.end(), this);
+		*it = simulated.back();
+		simulated.pop_back();
+	}
 }
 
 Component *RigidBody::clone() {
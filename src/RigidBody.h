@@ -46,6 +46,7 @@ public:
     [[nodiscard]] float getRotation() const;
     explicit RigidBody(float x = 0.0f, float y= 0.0f, float angle=0.0f, float angularFriction= 0.3f, float density= 1.0f, std::string bodyType = "dynamic", float gravityScale = 1.0f, bool precise = true, bool collider = true, bool trigger = true);
     explicit RigidBody(Deserializer& serial, Actor* act);
+    void applyDesc(const ComponentDesc& desc);
     void AddForce(b2::Vec2 vec) const;
     void setVelocity(b2::Vec2 vec) const;
     void setPosition(b2::Vec2 vec);
@@ -62,13 +63,28 @@ public:
     [[nodiscard]] b2::Vec2 getUpDirection() const;
     [[nodiscard]] b2::Vec2 getRightDirection() const;
     static inline b2::World* world = nullptr;
+    // every rigidbody that has a body in the world
+    static inline std::vector<RigidBody*> simulated;
+    // marks the actors of the bodies still awake after the physics step as moved in the spatial index
+    static void markAwakeMoved();
     Component* clone() override;
 
     [[nodiscard]] float getTorque() const;
 
+    // multiple return versions of the vector getters and setters, so scripts don't create a Vector2 each call.
+    // the getters are lua_CFunctions, non const since LuaBridge only binds those as members
+    int getPositionXY(lua_State* L);
+    int getVelocityXY(lua_State* L);
+    int getUpDirectionXY(lua_State* L);
+    int getRightDirectionXY(lua_State* L);
+    void setPositionXY(float newX, float newY);
+    void setVelocityXY(float newX, float newY) const;
+    void addForceXY(float forceX, float forceY) const;
+
     void serialize(Serializer &serial) override;
 
     ~RigidBody() override;
+    POOLED_OBJECT(RigidBody)
 };
 
 
@@ -0,0 +1,309 @@
+#ifndef SCENEBINARY_H
+#define SCENEBINARY_H
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <cstdio>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "SceneDesc.h"
+
+// Compiled scenes are written by the scene_compiler target next to their json as <name>.scene.bin
+// layout: magic, version, string table, the templates used with their modification times, streaming
+// settings, then actors referring to strings by index. Templates are already merged in and component
+// types and native fields are stored as ids
+
+inline constexpr char compiledSceneMagic[4] = {'K', 'S', 'C', 'N'};
+inline constexpr uint32_t compiledSceneVersion = 4;
+
+inline std::string compiledScenePath(const std::string& scenePath) {
+	return scenePath + ".bin";
+}
+
+// modification time of a template as stored in a compiled scene, 0 if the template is gone
+inline int64_t templateStamp(const std::string& path) {
+	std::error_code error;
+	const auto time = std::filesystem::last_write_time(path, error);
+	if (error) return 0;
+	return static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+// a compiled scene is only used if it is at least as new as the json it came from. Its templates are
+// checked by readCompiledScene, which has the list
+inline bool hasCompiledScene(const std::string& scenePath) {
+	const std::string compiled = compiledScenePath(scenePath);
+	if (!std::filesystem::exists(compiled)) return false;
+	if (!std::filesystem::exists(scenePath)) return true;
+	return std::filesystem::last_write_time(compiled) >= std::filesystem::last_write_time(scenePath);
+}
+
+class StringTable {
+public:
+	std::vector<std::string> strings;
+
+	uint32_t intern(const std::string& str) {
+		if (const auto it = ids.find(str); it != ids.end()) {
+			return it->second;
+		}
+		const auto id = static_cast<uint32_t>(strings.size());
+		strings.push_back(str);
+		ids.emplace(str, id);
+		return id;
+	}
+
+private:
+	std::unordered_map<std::string, uint32_t> ids;
+};
+
+template <typename T> void appendBinary(std::string& out, T value) {
+	char buf[sizeof(T)];
+	memcpy(buf, &value, sizeof(T));
+	out.append(buf, sizeof(T));
+}
+
+inline bool writeCompiledScene(const std::string& path, const SceneDesc& scene, const std::string& templateDir) {
+	const std::vector<ActorDesc>& actors = scene.actors;
+	StringTable table;
+	std::string body;
+	appendBinary<uint32_t>(body, static_cast<uint32_t>(scene.templates.size()));
+	for (const std::string& templateName : scene.templates) {
+		appendBinary<uint32_t>(body, table.intern(templateName));
+		appendBinary<int64_t>(body, templateStamp(templateDir + templateName + ".template"));
+	}
+	appendBinary<float>(body, scene.streaming.cellSize);
+	appendBinary<int32_t>(body, scene.streaming.loadRadius);
+	appendBinary<int32_t>(body, scene.streaming.unloadRadius);
+	appendBinary<uint32_t>(body, static_cast<uint32_t>(actors.size()));
+	for (const ActorDesc& actor : actors) {
+		appendBinary<uint32_t>(body, table.intern(actor.name));
+		appendBinary<uint32_t>(body, table.intern(actor.templateName));
+		appendBinary<uint8_t>(body, actor.hasPosition);
+		appendBinary<float>(body, actor.x);
+		appendBinary<float>(body, actor.y);
+		appendBinary<uint32_t>(body, static_cast<uint32_t>(actor.tags.size()));
+		for (const std::string& tag : actor.tags) {
+			appendBinary<uint32_t>(body, table.intern(tag));
+		}
+		appendBinary<uint32_t>(body, static_cast<uint32_t>(actor.components.size()));
+		for (const ComponentDesc& comp : actor.components) {
+			appendBinary<uint32_t>(body, table.intern(comp.key));
+			appendBinary<uint32_t>(body, table.intern(comp.type));
+			appendBinary<uint8_t>(body, static_cast<uint8_t>(comp.kind));
+			appendBinary<uint32_t>(body, static_cast<uint32_t>(comp.properties.size()));
+			for (const PropertyDesc& p : comp.properties) {
+				appendBinary<uint32_t>(body, table.intern(p.name));
+				appendBinary<int16_t>(body, p.field);
+				appendBinary<uint8_t>(body, static_cast<uint8_t>(p.kind));
+				switch (p.kind) {
+					case PropertyDesc::String:
+						appendBinary<uint32_t>(body, table.intern(p.string));
+						break;
+					case PropertyDesc::Int:
+						appendBinary<int32_t>(body, p.integer);
+						break;
+					case PropertyDesc::Float:
+						appendBinary<float>(body, p.number);
+						break;
+					case PropertyDesc::Bool:
+						appendBinary<uint8_t>(body, p.boolean);
+						break;
+				}
+			}
+		}
+	}
+
+	std::string header(compiledSceneMagic, sizeof(compiledSceneMagic));
+	appendBinary<uint32_t>(header, compiledSceneVersion);
+	appendBinary<uint32_t>(header, static_cast<uint32_t>(table.strings.size()));
+	for (const std::string& str : table.strings) {
+		appendBinary<uint32_t>(header, static_cast<uint32_t>(str.size()));
+		header.append(str);
+	}
+
+	std::ofstream file(path, std::ios_base::binary);
+	if (!file.is_open()) return false;
+	file.write(header.data(), static_cast<std::streamsize>(header.size()));
+	file.write(body.data(), static_cast<std::streamsize>(body.size()));
+	return file.good();
+}
+
+// read only view of a whole file, memory mapped where the platform allows it
+class MappedFile {
+public:
+	explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+		FILE* file = nullptr;
+		fopen_s(&file, path.c_str(), "rb");
+		if (!file) return;
+		fseek(file, 0, SEEK_END);
+		buffer.resize(ftell(file));
+		fseek(file, 0, SEEK_SET);
+		if (fread(buffer.data(), 1, buffer.size(), file) == buffer.size()) {
+			begin = buffer.data();
+			length = buffer.size();
+		}
+		fclose(file);
+#else
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) return;
+		struct stat info{};
+		if (fstat(fd, &info) == 0 && info.st_size > 0) {
+			void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (mapping != MAP_FAILED) {
+				begin = static_cast<const char*>(mapping);
+				length = info.st_size;
+			}
+		}
+		close(fd);
+#endif
+	}
+
+	~MappedFile() {
+#ifndef _WIN32
+		if (begin) munmap(const_cast<char*>(begin), length);
+#endif
+	}
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	[[nodiscard]] const char* data() const { return begin; }
+	[[nodiscard]] size_t size() const { return length; }
+
+private:
+	const char* begin = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	std::vector<char> buffer;
+#endif
+};
+
+class BinaryCursor {
+public:
+	const char* pos;
+	const char* end;
+	bool ok = true;
+
+	BinaryCursor(const char* data, size_t size) : pos(data), end(data + size) {}
+
+	template <typename T> T read() {
+		T value{};
+		if (static_cast<size_t>(end - pos) < sizeof(T)) {
+			ok = false;
+			return value;
+		}
+		memcpy(&value, pos, sizeof(T));
+		pos += sizeof(T);
+		return value;
+	}
+};
+
+// returns false if the file is missing, from another version, truncated or older than one of its templates,
+// callers then fall back to json
+inline bool readCompiledScene(const std::string& path, const std::string& templateDir, SceneDesc& out) {
+	const MappedFile file(path);
+	if (!file.data() || file.size() < sizeof(compiledSceneMagic)) return false;
+	if (memcmp(file.data(), compiledSceneMagic, sizeof(compiledSceneMagic)) != 0) return false;
+	BinaryCursor cursor(file.data() + sizeof(compiledSceneMagic), file.size() - sizeof(compiledSceneMagic));
+	if (cursor.read<uint32_t>() != compiledSceneVersion) return false;
+
+	// every counted entry takes at least a byte, so larger counts can only come from a corrupt file
+	auto count = [&]() -> uint32_t {
+		const auto n = cursor.read<uint32_t>();
+		if (n > static_cast<size_t>(cursor.end - cursor.pos)) {
+			cursor.ok = false;
+			return 0;
+		}
+		return n;
+	};
+
+	std::vector<std::string> strings(count());
+	for (std::string& str : strings) {
+		const auto len = cursor.read<uint32_t>();
+		if (!cursor.ok || static_cast<size_t>(cursor.end - cursor.pos) < len) return false;
+		str.assign(cursor.pos, len);
+		cursor.pos += len;
+	}
+	auto string = [&](uint32_t id) -> const std::string& {
+		static const std::string empty;
+		if (id >= strings.size()) {
+			cursor.ok = false;
+			return empty;
+		}
+		return strings[id];
+	};
+
+	std::vector<std::string> templates(count());
+	for (std::string& templateName : templates) {
+		templateName = string(cursor.read<uint32_t>());
+		const auto stamp = cursor.read<int64_t>();
+		if (!cursor.ok || stamp != templateStamp(templateDir + templateName + ".template")) return false;
+	}
+
+	StreamingDesc streaming;
+	streaming.cellSize = cursor.read<float>();
+	streaming.loadRadius = cursor.read<int32_t>();
+	streaming.unloadRadius = cursor.read<int32_t>();
+
+	std::vector<ActorDesc> actors(count());
+	for (ActorDesc& actor : actors) {
+		actor.name = string(cursor.read<uint32_t>());
+		actor.templateName = string(cursor.read<uint32_t>());
+		actor.hasPosition = cursor.read<uint8_t>() != 0;
+		actor.x = cursor.read<float>();
+		actor.y = cursor.read<float>();
+		actor.tags.resize(count());
+		for (std::string& tag : actor.tags) {
+			tag = string(cursor.read<uint32_t>());
+		}
+		actor.components.resize(count());
+		for (ComponentDesc& comp : actor.components) {
+			comp.key = string(cursor.read<uint32_t>());
+			comp.type = string(cursor.read<uint32_t>());
+			comp.kind = static_cast<ComponentKind>(cursor.read<uint8_t>());
+			comp.properties.resize(count());
+			for (PropertyDesc& p : comp.properties) {
+				p.name = string(cursor.read<uint32_t>());
+				p.field = cursor.read<int16_t>();
+				p.kind = static_cast<PropertyDesc::Kind>(cursor.read<uint8_t>());
+				switch (p.kind) {
+					case PropertyDesc::String:
+						p.string = string(cursor.read<uint32_t>());
+						break;
+					case PropertyDesc::Int:
+						p.integer = cursor.read<int32_t>();
+						break;
+					case PropertyDesc::Float:
+						p.number = cursor.read<float>();
+						break;
+					case PropertyDesc::Bool:
+						p.boolean = cursor.read<uint8_t>() != 0;
+						break;
+					default:
+						return false;
+				}
+			}
+			if (!cursor.ok) return false;
+			if (comp.kind == ComponentKind::Lua) resolveNativeFields(comp);
+		}
+	}
+	if (!cursor.ok) return false;
+	out.streaming = streaming;
+	out.templates.insert(out.templates.end(), templates.begin(), templates.end());
+	out.actors.insert(out.actors.end(), std::make_move_iterator(actors.begin()), std::make_move_iterator(actors.end()));
+	return true;
+}
+
+#endif //SCENEBINARY_H
@@ -0,0 +1,386 @@
+#ifndef SCENEDESC_H
+#define SCENEDESC_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef _WIN32
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated"
+#endif
+
+#include "rapidjson/document.h"
+#include "rapidjson/filereadstream.h"
+
+#ifndef _WIN32
+#pragma clang diagnostic pop
+#endif
+
+// native description of actors read from scene and template files
+// holds no lua state so it can be built off the main thread or by the scene compiler
+
+// false with the message in error instead of exiting, for readers on a worker thread
+inline bool TryReadJsonFile(const std::string& path, rapidjson::Document& out_document, std::string& error)
+{
+	FILE* file_pointer = nullptr;
+#ifdef _WIN32
+	fopen_s(&file_pointer, path.c_str(), "rb");
+#else
+	file_pointer = fopen(path.c_str(), "rb");
+#endif
+	if (file_pointer == nullptr) {
+		error = "error: could not open [" + path + "]";
+		return false;
+	}
+	char buffer[65536];
+	rapidjson::FileReadStream stream(file_pointer, buffer, sizeof(buffer));
+	out_document.ParseStream(stream);
+	std::fclose(file_pointer);
+
+	if (out_document.HasParseError()) {
+		error = "error parsing json at [" + path + "]";
+		return false;
+	}
+	return true;
+}
+
+inline void ReadJsonFile(const std::string& path, rapidjson::Document& out_document)
+{
+	std::string error;
+	if (!TryReadJsonFile(path, out_document, error)) {
+		std::cout << error << std::endl;
+		exit(0);
+	}
+}
+
+enum class ComponentKind : uint8_t { Lua, Rigidbody, ParticleSystem };
+
+// field ids of the native components, must stay in the same order as the name tables
+enum RigidbodyField : int16_t {
+	RB_X, RB_Y, RB_DENSITY, RB_ANGULAR_FRICTION, RB_GRAVITY_SCALE, RB_ROTATION, RB_BODY_TYPE,
+	RB_HAS_COLLIDER, RB_HAS_TRIGGER, RB_PRECISE, RB_WIDTH, RB_HEIGHT, RB_RADIUS, RB_FRICTION,
+	RB_BOUNCINESS, RB_COLLIDER_TYPE, RB_TRIGGER_TYPE, RB_TRIGGER_WIDTH, RB_TRIGGER_HEIGHT,
+	RB_TRIGGER_RADIUS, RB_FIELD_COUNT
+};
+
+inline const char* const rigidbodyFieldNames[RB_FIELD_COUNT] = {
+	"x", "y", "density", "angular_friction", "gravity_scale", "rotation", "body_type",
+	"has_collider", "has_trigger", "precise", "width", "height", "radius", "friction",
+	"bounciness", "collider_type", "trigger_type", "trigger_width", "trigger_height",
+	"trigger_radius"
+};
+
+enum ParticleSystemField : int16_t {
+	PS_X, PS_Y, PS_FRAMES_BETWEEN_BURSTS, PS_BURST_QUANTITY, PS_ROTATION_MIN, PS_ROTATION_MAX,
+	PS_START_SCALE_MIN, PS_START_SCALE_MAX, PS_START_COLOR_R, PS_START_COLOR_G, PS_START_COLOR_B,
+	PS_START_COLOR_A, PS_END_COLOR_R, PS_END_COLOR_G, PS_END_COLOR_B, PS_END_COLOR_A,
+	PS_EMIT_RADIUS_MIN, PS_EMIT_RADIUS_MAX, PS_EMIT_ANGLE_MIN, PS_EMIT_ANGLE_MAX, PS_IMAGE,
+	PS_SORTING_ORDER, PS_DURATION_FRAMES, PS_START_SPEED_MIN, PS_START_SPEED_MAX,
+	PS_ROTATION_SPEED_MIN, PS_ROTATION_SPEED_MAX, PS_GRAVITY_SCALE_X, PS_GRAVITY_SCALE_Y,
+	PS_DRAG_FACTOR, PS_ANGULAR_DRAG_FACTOR, PS_END_SCALE, PS_FIELD_COUNT
+};
+
+inline const char* const particleSystemFieldNames[PS_FIELD_COUNT] = {
+	"x", "y", "frames_between_bursts", "burst_quantity", "rotation_min", "rotation_max",
+	"start_scale_min", "start_scale_max", "start_color_r", "start_color_g", "start_color_b",
+	"start_color_a", "end_color_r", "end_color_g", "end_color_b", "end_color_a",
+	"emit_radius_min", "emit_radius_max", "emit_angle_min", "emit_angle_max", "image",
+	"sorting_order", "duration_frames", "start_speed_min", "start_speed_max",
+	"rotation_speed_min", "rotation_speed_max", "gravity_scale_x", "gravity_scale_y",
+	"drag_factor", "angular_drag_factor", "end_scale"
+};
+
+struct PropertyDesc {
+	enum Kind : char { String, Int, Float, Bool };
+	std::string name;
+	std::string string;
+	Kind kind = Int;
+	// index into the field table of a native component, -1 for lua components
+	int16_t field = -1;
+	int integer = 0;
+	float number = 0.0f;
+	bool boolean = false;
+
+	[[nodiscard]] float asFloat() const {
+		return kind == Int ? static_cast<float>(integer) : number;
+	}
+
+	[[nodiscard]] int asInt() const {
+		return kind == Float ? static_cast<int>(number) : integer;
+	}
+};
+
+struct ComponentDesc {
+	std::string key;
+	std::string type;
+	ComponentKind kind = ComponentKind::Lua;
+	std::vector<PropertyDesc> properties;
+
+	// overwrite a property of the same name, or add it
+	void set(const PropertyDesc& property) {
+		for (PropertyDesc& p : properties) {
+			if (p.name == property.name) {
+				p = property;
+				return;
+			}
+		}
+		properties.push_back(property);
+	}
+};
+
+struct ActorDesc {
+	std::string name;
+	std::string templateName;
+	std::vector<ComponentDesc> components;
+	// optional "position" of the actor in the scene file, used to place actors without a rigidbody
+	bool hasPosition = false;
+	float x = 0.0f, y = 0.0f;
+	std::vector<std::string> tags;
+
+	ComponentDesc* find(const std::string& key) {
+		for (ComponentDesc& c : components) {
+			if (c.key == key) return &c;
+		}
+		return nullptr;
+	}
+
+	// declared position, or where its rigidbody or transform starts. Needs the desc to be resolved first
+	bool findPosition(float& outX, float& outY) const {
+		if (hasPosition) {
+			outX = x;
+			outY = y;
+			return true;
+		}
+		for (const ComponentDesc& comp : components) {
+			const bool rigid = comp.kind == ComponentKind::Rigidbody;
+			if (!rigid && comp.type != "Transform") continue;
+			outX = 0.0f;
+			outY = 0.0f;
+			for (const PropertyDesc& p : comp.properties) {
+				if (rigid ? p.field == RB_X : p.name == "x") outX = p.asFloat();
+				else if (rigid ? p.field == RB_Y : p.name == "y") outY = p.asFloat();
+			}
+			return true;
+		}
+		return false;
+	}
+};
+
+// "streaming" block of a scene file. Cells are square, radii are counted in cells around the camera
+struct StreamingDesc {
+	float cellSize = 0.0f;
+	int loadRadius = 1;
+	int unloadRadius = 2;
+
+	[[nodiscard]] bool enabled() const { return cellSize > 0.0f; }
+};
+
+struct SceneDesc {
+	StreamingDesc streaming;
+	std::vector<ActorDesc> actors;
+	// names of the templates the actors were merged with, a compiled scene is stale once one of them changes
+	std::vector<std::string> templates;
+};
+
+inline ActorDesc readActorDesc(const rapidjson::Value& json) {
+	ActorDesc desc;
+	const auto end = json.MemberEnd();
+	if (auto it = json.FindMember("template"); it != end) {
+		desc.templateName = it->value.GetString();
+	}
+	if (auto it = json.FindMember("name"); it != end) {
+		desc.name = it->value.GetString();
+	}
+	if (auto it = json.FindMember("position"); it != end) {
+		desc.hasPosition = true;
+		if (auto x = it->value.FindMember("x"); x != it->value.MemberEnd()) desc.x = x->value.GetFloat();
+		if (auto y = it->value.FindMember("y"); y != it->value.MemberEnd()) desc.y = y->value.GetFloat();
+	}
+	if (auto it = json.FindMember("tags"); it != end) {
+		for (unsigned int i = 0; i < it->value.Size(); i++) {
+			desc.tags.emplace_back(it->value[i].GetString());
+		}
+	}
+	if (auto it = json.FindMember("components"); it != end) {
+		for (auto it2 = it->value.MemberBegin(); it2 != it->value.MemberEnd(); ++it2) {
+			ComponentDesc& comp = desc.components.emplace_back();
+			comp.key = it2->name.GetString();
+			for (auto it3 = it2->value.MemberBegin(); it3 != it2->value.MemberEnd(); ++it3) {
+				PropertyDesc prop;
+				prop.name = it3->name.GetString();
+				if (prop.name == "type") {
+					comp.type = it3->value.GetString();
+					continue;
+				}
+				if (it3->value.IsString()) {
+					prop.kind = PropertyDesc::String;
+					prop.string = it3->value.GetString();
+				}
+				else if (it3->value.IsInt()) {
+					prop.kind = PropertyDesc::Int;
+					prop.integer = it3->value.GetInt();
+				}
+				else if (it3->value.IsNumber()) {
+					prop.kind = PropertyDesc::Float;
+					prop.number = it3->value.GetFloat();
+				}
+				else if (it3->value.IsBool()) {
+					prop.kind = PropertyDesc::Bool;
+					prop.boolean = it3->value.GetBool();
+				}
+				else continue;
+				comp.properties.push_back(std::move(prop));
+			}
+		}
+	}
+	return desc;
+}
+
+// layers an actor's own values over the template it was declared with
+inline ActorDesc applyTemplate(const ActorDesc& templat, const ActorDesc& actor) {
+	ActorDesc resolved = templat;
+	resolved.templateName = actor.templateName;
+	if (!actor.name.empty()) resolved.name = actor.name;
+	if (actor.hasPosition) {
+		resolved.hasPosition = true;
+		resolved.x = actor.x;
+		resolved.y = actor.y;
+	}
+	// tags add to the template's
+	for (const std::string& tag : actor.tags) {
+		if (std::find(resolved.tags.begin(), resolved.tags.end(), tag) == resolved.tags.end()) resolved.tags.push_back(tag);
+	}
+	for (const ComponentDesc& comp : actor.components) {
+		if (ComponentDesc* inherited = resolved.find(comp.key)) {
+			for (const PropertyDesc& p : comp.properties) {
+				inherited->set(p);
+			}
+		}
+		else resolved.components.push_back(comp);
+	}
+	return resolved;
+}
+
+template <size_t N> int16_t findField(const char* const (&names)[N], const std::string& name) {
+	for (size_t i = 0; i < N; i++) {
+		if (name == names[i]) return static_cast<int16_t>(i);
+	}
+	return -1;
+}
+
+// field names of the native component types in field table order, by type name. Filled in by NativeComponents::add
+// before main and only read after that, so the loader thread can resolve against it too. Tools that don't link the
+// native components see it empty, so compiled scenes resolve native fields again when they are read
+inline std::unordered_map<std::string, std::vector<std::string>>& nativeFieldNames() {
+	static std::unordered_map<std::string, std::vector<std::string>> names;
+	return names;
+}
+
+// fields of a type that isn't native stay -1
+inline void resolveNativeFields(ComponentDesc& comp) {
+	const auto it = nativeFieldNames().find(comp.type);
+	for (PropertyDesc& p : comp.properties) {
+		p.field = -1;
+		if (it == nativeFieldNames().end()) continue;
+		const std::vector<std::string>& names = it->second;
+		for (size_t i = 0; i < names.size(); i++) {
+			if (p.name == names[i]) {
+				p.field = static_cast<int16_t>(i);
+				break;
+			}
+		}
+	}
+}
+
+// turns type and field names into ids once so building actors needs no string compares
+inline void resolveActorDesc(ActorDesc& desc) {
+	for (ComponentDesc& comp : desc.components) {
+		if (comp.type == "Rigidbody") {
+			comp.kind = ComponentKind::Rigidbody;
+			for (PropertyDesc& p : comp.properties) p.field = findField(rigidbodyFieldNames, p.name);
+		}
+		else if (comp.type == "ParticleSystem") {
+			comp.kind = ComponentKind::ParticleSystem;
+			for (PropertyDesc& p : comp.properties) p.field = findField(particleSystemFieldNames, p.name);
+		}
+		else {
+			comp.kind = ComponentKind::Lua;
+			resolveNativeFields(comp);
+		}
+	}
+}
+
+inline StreamingDesc readStreamingDesc(const rapidjson::Value& json) {
+	StreamingDesc desc;
+	const auto end = json.MemberEnd();
+	if (auto it = json.FindMember("cell_size"); it != end) desc.cellSize = it->value.GetFloat();
+	if (auto it = json.FindMember("load_radius"); it != end) desc.loadRadius = it->value.GetInt();
+	if (auto it = json.FindMember("unload_radius"); it != end) desc.unloadRadius = it->value.GetInt();
+	// cells between the two radii stay as they are, so actors near the edge don't load and unload every frame
+	if (desc.loadRadius < 0) desc.loadRadius = 0;
+	if (desc.unloadRadius <= desc.loadRadius) desc.unloadRadius = desc.loadRadius + 1;
+	return desc;
+}
+
+// resolves every actor of an already parsed .scene file against its template. Returns false with the
+// message in error if a template is missing or broken, it never exits so it can run on a worker thread
+inline bool readSceneDesc(const rapidjson::Document& doc, const std::string& templateDir, SceneDesc& out, std::string& error) {
+	if (auto it = doc.FindMember("streaming"); it != doc.MemberEnd()) {
+		out.streaming = readStreamingDesc(it->value);
+	}
+
+	std::unordered_map<std::string, ActorDesc> templates;
+	auto& arr = doc["actors"];
+	out.actors.reserve(out.actors.size() + arr.Size());
+	for (unsigned int i = 0; i < arr.Size(); i++) {
+		ActorDesc desc = readActorDesc(arr[i]);
+		if (!desc.templateName.empty()) {
+			auto it = templates.find(desc.templateName);
+			if (it == templates.end()) {
+				const std::string templatePath = templateDir + desc.templateName + ".template";
+				if (!std::filesystem::exists(templatePath)) {
+					error = "error: template " + desc.templateName + " is missing";
+					return false;
+				}
+				rapidjson::Document templat;
+				if (!TryReadJsonFile(templatePath, templat, error)) return false;
+				it = templates.emplace(desc.templateName, readActorDesc(templat)).first;
+				out.templates.push_back(desc.templateName);
+			}
+			desc = applyTemplate(it->second, desc);
+		}
+		resolveActorDesc(desc);
+		out.actors.push_back(std::move(desc));
+	}
+	return true;
+}
+
+inline bool readSceneDesc(const std::string& path, const std::string& templateDir, SceneDesc& out, std::string& error) {
+	rapidjson::Document doc;
+	if (!TryReadJsonFile(path, doc, error)) return false;
+	return readSceneDesc(doc, templateDir, out, error);
+}
+
+// removes the actors that get streamed in by position instead of being built with the scene
+inline std::vector<ActorDesc> takeStreamedActors(SceneDesc& scene) {
+	std::vector<ActorDesc> streamed;
+	if (!scene.streaming.enabled()) return streamed;
+	const auto split = std::stable_partition(scene.actors.begin(), scene.actors.end(), [](const ActorDesc& desc) {
+		float x, y;
+		return !desc.findPosition(x, y);
+	});
+	streamed.assign(std::make_move_iterator(split), std::make_move_iterator(scene.actors.end()));
+	scene.actors.erase(split, scene.actors.end());
+	return streamed;
+}
+
+#endif //SCENEDESC_H
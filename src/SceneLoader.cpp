@@ -0,0 +1,116 @@
+#include "SceneLoader.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+
+#include "scene.hpp"
+#include "SceneBinary.h"
+#include "luafuncs.h"
+
+using luabridge::LuaRef;
+using luabridge::LuaException;
+
+const std::string scenePath = "resources/scenes/";
+const std::string templateBase = "resources/actor_templates/";
+
+SceneLoader::PendingLoad::PendingLoad(std::string name, const LuaRef& progress, const LuaRef& complete)
+	: name(std::move(name)), onProgress(progress), onComplete(complete) {}
+
+SceneLoader::PendingLoad::~PendingLoad() {
+	if (worker.joinable()) worker.join();
+	// only non-empty if the load was replaced before it finished
+	for (const Actor* actor : built) {
+		delete actor;
+	}
+}
+
+void SceneLoader::readScene(PendingLoad* load) {
+	const std::string path = scenePath + load->name + ".scene";
+	// errors are left for update to report, exiting here would pull the process out from under the main thread
+	if (!hasCompiledScene(path) || !readCompiledScene(compiledScenePath(path), templateBase, load->desc)) {
+		if (!std::filesystem::exists(path)) {
+			load->error = "error: scene " + load->name + " is missing";
+		}
+		else readSceneDesc(path, templateBase, load->desc, load->error);
+	}
+	if (load->error.empty()) load->streamed = takeStreamedActors(load->desc);
+	load->parsed = true;
+}
+
+void SceneLoader::loadAsync(const std::string& sceneName, const LuaRef& onProgress, const LuaRef& onComplete) {
+	cancel();
+	pending = std::make_unique<PendingLoad>(sceneName, onProgress, onComplete);
+	pending->worker = std::thread(readScene, pending.get());
+}
+
+void SceneLoader::cancel() {
+	loads++;
+	pending.reset();
+}
+
+bool SceneLoader::isLoading() {
+	return pending != nullptr;
+}
+
+float SceneLoader::getProgress() {
+	if (!pending || !pending->parsed) return 0.0f;
+	if (pending->desc.actors.empty()) return 1.0f;
+	return static_cast<float>(pending->next) / static_cast<float>(pending->desc.actors.size());
+}
+
+void SceneLoader::update(Scene& scene) {
+	if (!pending || !pending->parsed) return;
+	// building actors and the callbacks use the lua state the autosave thread reads
+	std::unique_lock lock(autosaving_mutex);
+	PendingLoad& load = *pending;
+	if (load.worker.joinable()) load.worker.join();
+	if (!load.error.empty()) {
+		std::cout << load.error;
+		exit(0);
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const std::vector<ActorDesc>& descs = load.desc.actors;
+	while (load.next < descs.size()) {
+		load.built.push_back(new Actor(descs[load.next]));
+		load.next++;
+		const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() >= frameBudget) break;
+	}
+	if (!load.onProgress.isNil()) {
+		// a callback that starts another load frees this one, and the LuaRef being called with it
+		const LuaRef onProgress = load.onProgress;
+		const uint64_t started = loads;
+		try {
+			onProgress(getProgress());
+		}
+		catch (const LuaException& e) {
+			ReportError("Scene", e);
+		}
+		// compared by count, a new load can be allocated where the old one was
+		if (loads != started) return;
+	}
+	if (load.next < descs.size()) return;
+
+	// everything is built, swap scenes the same way Scene.Load does
+	std::vector<Actor*> acts = scene.actors;
+	std::unordered_map<std::string, Actor> templates = std::move(scene.templates);
+	const std::string name = load.name;
+	scene.~Scene();
+	new(&scene) Scene(name, acts, templates, load.built);
+	scene.streamer.configure(load.desc.streaming, std::move(load.streamed));
+	load.built.clear();
+
+	const LuaRef onComplete = load.onComplete;
+	pending.reset();
+	if (!onComplete.isNil()) {
+		try {
+			onComplete();
+		}
+		catch (const LuaException& e) {
+			ReportError("Scene", e);
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#ifndef SCENELOADER_H
+#define SCENELOADER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lua.hpp"
+#include "LuaBridge.h"
+
+#include "SceneDesc.h"
+
+class Scene;
+class Actor;
+
+// Loads a scene in the background. File reads, json parsing and template resolution
+// happen on a worker thread, actors are then built on the main thread a few at a time
+class SceneLoader {
+public:
+	static void loadAsync(const std::string& sceneName, const luabridge::LuaRef& onProgress, const luabridge::LuaRef& onComplete);
+	// called once per frame from the main loop, swaps the scene in once every actor is built
+	static void update(Scene& scene);
+	static bool isLoading();
+	// drops the load in progress, so a scene switched to some other way isn't replaced by it later
+	static void cancel();
+	static float getProgress();
+
+	// milliseconds per frame spent constructing actors
+	static inline double frameBudget = 4.0;
+
+private:
+	struct PendingLoad {
+		std::string name;
+		std::thread worker;
+		std::atomic<bool> parsed = false;
+		// set by the worker instead of exiting, reported by update on the main thread
+		std::string error;
+		SceneDesc desc;
+		// positioned actors of a streaming scene, handed to the scene's streamer instead of being built
+		std::vector<ActorDesc> streamed;
+		std::vector<Actor*> built;
+		size_t next = 0;
+		luabridge::LuaRef onProgress;
+		luabridge::LuaRef onComplete;
+		PendingLoad(std::string name, const luabridge::LuaRef& progress, const luabridge::LuaRef& complete);
+		~PendingLoad();
+	};
+
+	static void readScene(PendingLoad* load);
+
+	static inline std::unique_ptr<PendingLoad> pending;
+	// bumped whenever pending is replaced or dropped
+	static inline uint64_t loads = 0;
+};
+
+#endif //SCENELOADER_H
@@ -0,0 +1,118 @@
+#include "ScriptCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace {
+	constexpr char magic[4] = {'K', 'L', 'C', '1'};
+
+	int writeChunk(lua_State*, const void* data, size_t size, void* out) {
+		auto* bytes = static_cast<std::vector<char>*>(out);
+		bytes->insert(bytes->end(), static_cast<const char*>(data), static_cast<const char*>(data) + size);
+		return 0;
+	}
+}
+
+uint64_t ScriptCache::hash(const std::string& source) {
+	// FNV-1a
+	uint64_t h = 14695981039346656037ull;
+	for (const char c : source) {
+		h ^= static_cast<unsigned char>(c);
+		h *= 1099511628211ull;
+	}
+	return h;
+}
+
+std::filesystem::path ScriptCache::cacheFile(const Script& script) {
+	return cachePath + script.path.parent_path().filename().string() + "/" + script.path.stem().string() + ".luac";
+}
+
+bool ScriptCache::readCache(Script& script) {
+	std::ifstream in(cacheFile(script), std::ios::binary);
+	if (!in) return false;
+	char header[sizeof(magic)];
+	uint64_t sourceHash = 0;
+	uint32_t version = 0;
+	in.read(header, sizeof(header));
+	in.read(reinterpret_cast<char*>(&sourceHash), sizeof(sourceHash));
+	in.read(reinterpret_cast<char*>(&version), sizeof(version));
+	if (!in || std::memcmp(header, magic, sizeof(magic)) != 0 || sourceHash != script.hash || version != LUA_VERSION_NUM) return false;
+	script.bytecode.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	return !script.bytecode.empty();
+}
+
+void ScriptCache::writeCache(const Script& script) {
+	// the cache only saves time, a read only resources folder just means compiling every launch
+	std::error_code error;
+	const std::filesystem::path file = cacheFile(script);
+	std::filesystem::create_directories(file.parent_path(), error);
+	if (error) return;
+	std::ofstream out(file, std::ios::binary | std::ios::trunc);
+	if (!out) return;
+	const uint32_t version = LUA_VERSION_NUM;
+	out.write(magic, sizeof(magic));
+	out.write(reinterpret_cast<const char*>(&script.hash), sizeof(script.hash));
+	out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+	out.write(script.bytecode.data(), static_cast<std::streamsize>(script.bytecode.size()));
+}
+
+void ScriptCache::compileRange(Script* begin, Script* end) {
+	lua_State* L = luaL_newstate();
+	for (Script* script = begin; script != end; ++script) {
+		// same chunk name as luaL_dofile, it is kept in the dump so errors still name the file
+		const std::string name = "@" + script->path.string();
+		if (luaL_loadbufferx(L, script->source.data(), script->source.size(), name.c_str(), "t") != LUA_OK) {
+			script->error = lua_tostring(L, -1);
+		}
+		else lua_dump(L, writeChunk, &script->bytecode, 0);
+		lua_settop(L, 0);
+	}
+	lua_close(L);
+}
+
+std::vector<ScriptCache::Script> ScriptCache::compile(const std::vector<std::filesystem::path>& files) {
+	std::vector<Script> scripts(files.size());
+	std::vector<Script*> cold;
+	for (size_t i = 0; i < files.size(); i++) {
+		Script& script = scripts[i];
+		script.path = files[i];
+		std::ifstream in(script.path, std::ios::binary);
+		script.source.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		script.hash = hash(script.source);
+		if (!readCache(script)) cold.push_back(&script);
+	}
+	if (cold.empty()) return scripts;
+
+	// cold scripts are gathered so each worker gets a contiguous run of them
+	std::vector<Script> compiling;
+	compiling.reserve(cold.size());
+	for (Script* script : cold) compiling.push_back(std::move(*script));
+	const size_t workers = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, compiling.size());
+	const size_t perWorker = (compiling.size() + workers - 1) / workers;
+	std::vector<std::thread> threads;
+	for (size_t start = perWorker; start < compiling.size(); start += perWorker) {
+		threads.emplace_back(compileRange, compiling.data() + start, compiling.data() + std::min(start + perWorker, compiling.size()));
+	}
+	compileRange(compiling.data(), compiling.data() + perWorker);
+	for (std::thread& thread : threads) thread.join();
+	for (size_t i = 0; i < cold.size(); i++) {
+		*cold[i] = std::move(compiling[i]);
+		if (cold[i]->error.empty()) writeCache(*cold[i]);
+	}
+	return scripts;
+}
+
+int ScriptCache::load(lua_State* L, const Script& script) {
+	if (!script.error.empty()) {
+		lua_pushstring(L, script.error.c_str());
+		return LUA_ERRSYNTAX;
+	}
+	const std::string name = "@" + script.path.string();
+	if (luaL_loadbufferx(L, script.bytecode.data(), script.bytecode.size(), name.c_str(), "b") == LUA_OK) return LUA_OK;
+	// a dump from a differently built Lua, compile the source instead
+	lua_pop(L, 1);
+	return luaL_loadbufferx(L, script.source.data(), script.source.size(), name.c_str(), "t");
+}
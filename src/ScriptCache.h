@@ -0,0 +1,41 @@
+#ifndef SCRIPTCACHE_H
+#define SCRIPTCACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "lua.hpp"
+
+// Keeps compiled Lua chunks next to the game's resources so unchanged scripts skip the parser on launch.
+// Each cache file holds a hash of the source it was built from and is thrown away once the source changes.
+// Scripts missing from the cache are compiled on worker threads, each with its own lua_State
+class ScriptCache {
+public:
+	struct Script {
+		std::filesystem::path path;
+		std::string source;
+		uint64_t hash = 0;
+		std::vector<char> bytecode;
+		// compile error from a worker
+		std::string error;
+	};
+
+	// reads every file and finds or builds its bytecode, in the order given
+	static std::vector<Script> compile(const std::vector<std::filesystem::path>& files);
+	// pushes the script's chunk like luaL_loadfile, or its error message when it does not compile
+	static int load(lua_State* L, const Script& script);
+
+	static inline const std::string cachePath = "resources/.cache/";
+
+private:
+	static uint64_t hash(const std::string& source);
+	static bool readCache(Script& script);
+	static void writeCache(const Script& script);
+	static std::filesystem::path cacheFile(const Script& script);
+	// compiles and dumps every script in [begin, end) in a state of its own
+	static void compileRange(Script* begin, Script* end);
+};
+
+#endif //SCRIPTCACHE_H
@@ -0,0 +1,117 @@
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "scene.hpp"
+
+int SpatialIndex::cellOf(float v) {
+	return static_cast<int>(std::floor(v / cellSize));
+}
+
+uint64_t SpatialIndex::cellKey(int x, int y) {
+	return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y);
+}
+
+void SpatialIndex::removeFromBucket(Actor* actor, uint64_t key) {
+	const auto bucket = buckets.find(key);
+	if (bucket == buckets.end()) return;
+	std::vector<Actor*>& vec = bucket->second;
+	for (size_t i = 0; i < vec.size(); i++) {
+		if (vec[i] == actor) {
+			vec[i] = vec.back();
+			vec.pop_back();
+			break;
+		}
+	}
+	if (vec.empty()) buckets.erase(bucket);
+}
+
+void SpatialIndex::update() {
+	for (Actor* actor : moved) {
+		actor->spatialMoved = false;
+		// not in the scene yet, indexActor marks it again once it is
+		if (!actor->indexed) continue;
+		b2::Vec2 pos;
+		const auto it = cells.find(actor);
+		if (!actor->findPosition(pos)) {
+			// its rigidbody was removed since the last frame
+			if (it != cells.end()) {
+				removeFromBucket(actor, it->second);
+				cells.erase(it);
+			}
+			continue;
+		}
+		const uint64_t key = cellKey(cellOf(pos.x), cellOf(pos.y));
+		if (it != cells.end()) {
+			if (it->second == key) continue;
+			removeFromBucket(actor, it->second);
+			it->second = key;
+		}
+		else cells.emplace(actor, key);
+		buckets[key].push_back(actor);
+	}
+	moved.clear();
+}
+
+void SpatialIndex::markMoved(Actor* actor) {
+	if (!actor || actor->spatialMoved) return;
+	actor->spatialMoved = true;
+	moved.push_back(actor);
+}
+
+void SpatialIndex::forget(Actor* actor) {
+	if (!actor->spatialMoved) return;
+	moved.erase(std::find(moved.begin(), moved.end(), actor));
+	actor->spatialMoved = false;
+}
+
+void SpatialIndex::remove(Actor* actor) {
+	if (const auto it = cells.find(actor); it != cells.end()) {
+		removeFromBucket(actor, it->second);
+		cells.erase(it);
+	}
+}
+
+void SpatialIndex::queryRect(float minX, float minY, float maxX, float maxY, std::vector<Actor*>& out) const {
+	auto inside = [&](const Actor* actor) {
+		b2::Vec2 pos;
+		actor->findPosition(pos);
+		return pos.x >= minX && pos.x <= maxX && pos.y >= minY && pos.y <= maxY;
+	};
+	const int startX = cellOf(minX), endX = cellOf(maxX);
+	const int startY = cellOf(minY), endY = cellOf(maxY);
+	const double area = (static_cast<double>(endX) - startX + 1) * (static_cast<double>(endY) - startY + 1);
+	// a query bigger than the occupied part of the world is cheaper as a scan over the buckets
+	if (area > static_cast<double>(buckets.size())) {
+		for (const auto& [key, bucket] : buckets) {
+			for (Actor* actor : bucket) {
+				if (inside(actor)) out.push_back(actor);
+			}
+		}
+		return;
+	}
+	for (int y = startY; y <= endY; y++) {
+		for (int x = startX; x <= endX; x++) {
+			const auto bucket = buckets.find(cellKey(x, y));
+			if (bucket == buckets.end()) continue;
+			for (Actor* actor : bucket->second) {
+				if (inside(actor)) out.push_back(actor);
+			}
+		}
+	}
+}
+
+void SpatialIndex::queryRadius(float x, float y, float radius, std::vector<Actor*>& out) const {
+	const size_t first = out.size();
+	queryRect(x - radius, y - radius, x + radius, y + radius, out);
+	const float radiusSq = radius * radius;
+	size_t kept = first;
+	for (size_t i = first; i < out.size(); i++) {
+		b2::Vec2 pos;
+		out[i]->findPosition(pos);
+		const float dx = pos.x - x, dy = pos.y - y;
+		if (dx * dx + dy * dy <= radiusSq) out[kept++] = out[i];
+	}
+	out.resize(kept);
+}
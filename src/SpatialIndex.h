@@ -0,0 +1,42 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Actor;
+
+// Spatial hash over every actor with a position, refreshed once per frame after the physics step.
+// Only actors marked as moved since the last refresh are looked at, and they only move between
+// buckets when they cross a cell boundary
+class SpatialIndex {
+public:
+	// rechecks the actors marked as moved, in any scene, and clears the marks
+	void update();
+	// queues an actor whose position may have changed for the next update, once per frame
+	static void markMoved(Actor* actor);
+	// drops an actor that is being deleted from the moved list
+	static void forget(Actor* actor);
+	// must be called before an indexed actor is deleted
+	void remove(Actor* actor);
+	void queryRect(float minX, float minY, float maxX, float maxY, std::vector<Actor*>& out) const;
+	void queryRadius(float x, float y, float radius, std::vector<Actor*>& out) const;
+	[[nodiscard]] size_t size() const { return cells.size(); }
+
+	// world units per cell, queries cost roughly their area divided by this squared
+	static constexpr float cellSize = 4.0f;
+
+private:
+	// engine wide since actors move before their scene exists, e.g. while a SceneLoader builds them
+	static inline std::vector<Actor*> moved;
+	std::unordered_map<uint64_t, std::vector<Actor*>> buckets;
+	std::unordered_map<Actor*, uint64_t> cells;
+
+	static int cellOf(float v);
+	static uint64_t cellKey(int x, int y);
+	void removeFromBucket(Actor* actor, uint64_t key);
+};
+
+#endif //SPATIALINDEX_H
@@ -0,0 +1,44 @@
+#include "SpriteRenderer.h"
+
+#include "Rendering.h"
+#include "RigidBody.h"
+#include "Transform.h"
+
+REGISTER_NATIVE_COMPONENT(SpriteRenderer)
+
+void SpriteRenderer::enqueue(Scene& scene) {
+	const ComponentType spriteType = registration->type;
+	for (const Actor* actor : scene.actors) {
+		const auto sprites = actor->componentsByType.find(spriteType);
+		if (sprites == actor->componentsByType.end() || sprites->second.empty()) continue;
+
+		b2::Vec2 pos = actor->position;
+		float rotation = 0.0f;
+		float transformScaleX = 1.0f;
+		float transformScaleY = 1.0f;
+		if (const auto it = actor->componentsByType.find(ComponentTypes::Transform); it != actor->componentsByType.end() && !it->second.empty()) {
+			const auto* transform = static_cast<const Transform*>(it->second.front());
+			pos = transform->getPosition();
+			rotation = transform->getRotation();
+			transformScaleX = transform->getScaleX();
+			transformScaleY = transform->getScaleY();
+		}
+		if (const auto it = actor->componentsByType.find(ComponentTypes::Rigidbody); it != actor->componentsByType.end() && !it->second.empty()) {
+			const auto* rb = static_cast<const RigidBody*>(it->second.front());
+			pos = rb->getPosition();
+			rotation = rb->getRotation();
+		}
+
+		for (Component* component : sprites->second) {
+			auto* sprite = static_cast<SpriteRenderer*>(component);
+			if (!sprite->enabled || sprite->image.empty()) continue;
+			if (sprite->loadedImage != sprite->image) {
+				sprite->texture = getImage(renderer, sprite->image);
+				sprite->loadedImage = sprite->image;
+			}
+			scene.renderQueue.emplace_back(sprite->texture, pos.x, pos.y, sprite->scaleX * transformScaleX, sprite->scaleY * transformScaleY,
+				rotation, sprite->pivotX, sprite->pivotY, sprite->sortingOrder,
+				static_cast<uint8_t>(sprite->r), static_cast<uint8_t>(sprite->g), static_cast<uint8_t>(sprite->b), static_cast<uint8_t>(sprite->a));
+		}
+	}
+}
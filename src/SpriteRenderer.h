@@ -0,0 +1,46 @@
+#ifndef SPRITERENDERER_H
+#define SPRITERENDERER_H
+
+#include <string>
+
+#include "NativeComponent.h"
+
+// Draws an image at its actor's Rigidbody, Transform or explicit position every frame without any lua.
+// Scale and rotation of a Transform are applied on top of the sprite's own
+class SpriteRenderer : public NativeComponent<SpriteRenderer> {
+public:
+	std::string image;
+	float pivotX = 0.5f;
+	float pivotY = 0.5f;
+	float scaleX = 1.0f;
+	float scaleY = 1.0f;
+	int r = 255;
+	int g = 255;
+	int b = 255;
+	int a = 255;
+	int sortingOrder = 0;
+
+	static constexpr auto fields() {
+		return std::make_tuple(
+			field("image", &SpriteRenderer::image),
+			field("pivot_x", &SpriteRenderer::pivotX),
+			field("pivot_y", &SpriteRenderer::pivotY),
+			field("scale_x", &SpriteRenderer::scaleX),
+			field("scale_y", &SpriteRenderer::scaleY),
+			field("r", &SpriteRenderer::r),
+			field("g", &SpriteRenderer::g),
+			field("b", &SpriteRenderer::b),
+			field("a", &SpriteRenderer::a),
+			field("sorting_order", &SpriteRenderer::sortingOrder));
+	}
+
+	// queues every enabled sprite of the scene's actors, called once per frame before rendering
+	static void enqueue(Scene& scene);
+
+private:
+	// resolved once per image name instead of hashing the name every frame
+	TextureId texture = 0;
+	std::string loadedImage;
+};
+
+#endif //SPRITERENDERER_H
@@ -0,0 +1,49 @@
+#ifndef TAGTABLE_H
+#define TAGTABLE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Tags are registered the first time a scene file, template or script uses them, each one is a bit of Actor::tags
+class TagTable {
+public:
+	static constexpr int maxTags = 64;
+
+	static int id(const std::string& name) {
+		if (const auto it = ids.find(name); it != ids.end()) {
+			return it->second;
+		}
+		if (names.size() == maxTags) {
+			std::cout << "error: more than 64 actor tags, " + name + " can't be added";
+			exit(0);
+		}
+		const int tag = static_cast<int>(names.size());
+		names.push_back(name);
+		ids.emplace(name, tag);
+		return tag;
+	}
+
+	// -1 for tags that were never registered, without registering them
+	static int find(const std::string& name) {
+		const auto it = ids.find(name);
+		return it == ids.end() ? -1 : it->second;
+	}
+
+	static const std::string& name(int tag) {
+		return names[tag];
+	}
+
+	static uint64_t bit(int tag) {
+		return uint64_t{1} << tag;
+	}
+
+private:
+	static inline std::unordered_map<std::string, int> ids;
+	static inline std::vector<std::string> names;
+};
+
+#endif //TAGTABLE_H
@@ -0,0 +1,42 @@
+#ifndef TEXTUREREGISTRY_H
+#define TEXTUREREGISTRY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "SDL.h"
+
+using TextureId = uint32_t;
+
+struct TextureInfo {
+	SDL_Texture* texture = nullptr;
+	float width = 0.0f;
+	float height = 0.0f;
+	// the part of the texture that is drawn, the whole texture until images are packed into atlases
+	SDL_FRect source = {0.0f, 0.0f, 0.0f, 0.0f};
+};
+
+// Every texture the engine draws, with its size read once when the texture is created. Render requests
+// refer to textures by their id here, so building and drawing them never has to ask the renderer
+class TextureRegistry {
+public:
+	static inline std::vector<TextureInfo> textures;
+
+	static TextureId add(SDL_Texture* texture) {
+		TextureInfo info;
+		info.texture = texture;
+		int w = 0, h = 0;
+		if (texture) SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
+		info.width = static_cast<float>(w);
+		info.height = static_cast<float>(h);
+		info.source = {0.0f, 0.0f, info.width, info.height};
+		textures.push_back(info);
+		return static_cast<TextureId>(textures.size() - 1);
+	}
+
+	static const TextureInfo& get(TextureId id) {
+		return textures[id];
+	}
+};
+
+#endif //TEXTUREREGISTRY_H
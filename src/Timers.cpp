@@ -0,0 +1,138 @@
+#include "Timers.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "FrameArena.h"
+#include "scene.hpp"
+
+using luabridge::LuaRef;
+
+uint64_t Timers::after(int frames, const LuaRef& callback) {
+	return schedule(frames, 0, callback);
+}
+
+uint64_t Timers::every(int frames, const LuaRef& callback) {
+	return schedule(frames, delay(frames), callback);
+}
+
+uint32_t Timers::delay(int frames) {
+	// raised to 1 while still signed, a negative count converted to unsigned first would become the longest delay
+	return static_cast<uint32_t>(std::min<uint64_t>(static_cast<uint64_t>(std::max(frames, 1)), maxDelay));
+}
+
+uint64_t Timers::schedule(int frames, uint32_t interval, const LuaRef& callback) {
+	int32_t index;
+	if (!freeTimers.empty()) {
+		index = freeTimers.back();
+		freeTimers.pop_back();
+		timers[index].callback = callback;
+	}
+	else {
+		index = static_cast<int32_t>(timers.size());
+		timers.push_back({callback});
+	}
+	Timer& timer = timers[index];
+	timer.due = now + delay(frames);
+	timer.interval = interval;
+	timer.active = true;
+	link(index);
+	return static_cast<uint64_t>(timer.generation) << 32 | static_cast<uint32_t>(index);
+}
+
+void Timers::cancel(uint64_t handle) {
+	const auto index = static_cast<int32_t>(static_cast<uint32_t>(handle));
+	if (index >= static_cast<int32_t>(timers.size())) return;
+	Timer& timer = timers[index];
+	if (!timer.active || timer.generation != handle >> 32) return;
+	if (timer.slot >= 0) unlink(index);
+	release(index);
+}
+
+int Timers::slotFor(uint64_t due) {
+	const uint64_t delta = due - now;
+	if (delta < (1 << 8)) return static_cast<int>(due & 255);
+	if (delta < (1 << 14)) return 256 + static_cast<int>((due >> 8) & 63);
+	if (delta < (1 << 20)) return 256 + 64 + static_cast<int>((due >> 14) & 63);
+	return 256 + 128 + static_cast<int>((due >> 20) & 63);
+}
+
+void Timers::link(int32_t index) {
+	Timer& timer = timers[index];
+	timer.slot = slotFor(timer.due);
+	timer.prev = tails[timer.slot];
+	timer.next = -1;
+	if (timer.prev >= 0) timers[timer.prev].next = index;
+	else heads[timer.slot] = index;
+	tails[timer.slot] = index;
+}
+
+void Timers::unlink(int32_t index) {
+	Timer& timer = timers[index];
+	if (timer.prev >= 0) timers[timer.prev].next = timer.next;
+	else heads[timer.slot] = timer.next;
+	if (timer.next >= 0) timers[timer.next].prev = timer.prev;
+	else tails[timer.slot] = timer.prev;
+	timer.slot = -1;
+}
+
+void Timers::release(int32_t index) {
+	Timer& timer = timers[index];
+	timer.active = false;
+	timer.generation++;
+	// drop the function so whatever it captured can be collected
+	timer.callback = LuaRef(timer.callback.state());
+	freeTimers.push_back(index);
+}
+
+void Timers::cascade(int slot) {
+	int32_t index = heads[slot];
+	heads[slot] = -1;
+	tails[slot] = -1;
+	while (index >= 0) {
+		const int32_t next = timers[index].next;
+		link(index);
+		index = next;
+	}
+}
+
+void Timers::advance() {
+	now++;
+	const int wheel = static_cast<int>(now & 255);
+	if (wheel == 0) {
+		const int level1 = static_cast<int>((now >> 8) & 63);
+		cascade(256 + level1);
+		if (level1 == 0) {
+			const int level2 = static_cast<int>((now >> 14) & 63);
+			cascade(256 + 64 + level2);
+			if (level2 == 0) cascade(256 + 128 + static_cast<int>((now >> 20) & 63));
+		}
+	}
+
+	// taken out of the slot first, callbacks can schedule and cancel any timer including these
+	FrameVector<std::pair<int32_t, uint32_t>> due;
+	for (int32_t index = heads[wheel]; index >= 0; index = timers[index].next) {
+		due.emplace_back(index, timers[index].generation);
+		timers[index].slot = -1;
+	}
+	heads[wheel] = -1;
+	tails[wheel] = -1;
+	for (const auto& [index, generation] : due) {
+		if (!timers[index].active || timers[index].generation != generation) continue;
+		// a copy, the callback may grow the timer list
+		const LuaRef callback = timers[index].callback;
+		try {
+			callback();
+		}
+		catch (const luabridge::LuaException& e) {
+			ReportError("Timer", e);
+		}
+		Timer& timer = timers[index];
+		if (!timer.active || timer.generation != generation) continue;
+		if (timer.interval) {
+			timer.due += timer.interval;
+			link(index);
+		}
+		else release(index);
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef TIMERS_H
+#define TIMERS_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "lua.hpp"
+#include "LuaBridge.h"
+
+// Frame timers in a hierarchical timing wheel: 256 one frame slots, then three levels of 64 slots that
+// each cover 64 slots of the level below. Scheduling and cancelling only link or unlink a timer in one
+// slot's list, and timers far in the future are moved down a level once every 256 frames or more.
+// Handles pack a timer index and generation so cancelling a finished timer does nothing
+class Timers {
+public:
+	static uint64_t after(int frames, const luabridge::LuaRef& callback);
+	static uint64_t every(int frames, const luabridge::LuaRef& callback);
+	static void cancel(uint64_t handle);
+	// moves time on by one frame and calls the timers that are due, once per frame after the actors' update
+	static void advance();
+
+	// longest delay, about 12 days at 60 frames a second
+	static constexpr uint64_t maxDelay = (uint64_t{1} << 26) - 1;
+
+private:
+	struct Timer {
+		luabridge::LuaRef callback;
+		uint64_t due = 0;
+		uint32_t interval = 0;
+		uint32_t generation = 0;
+		int32_t prev = -1;
+		int32_t next = -1;
+		// -1 while the timer is not in any slot
+		int32_t slot = -1;
+		bool active = false;
+	};
+
+	static constexpr int slotCount = 256 + 3 * 64;
+
+	static inline std::vector<Timer> timers;
+	static inline std::vector<int32_t> freeTimers;
+	// each slot's list is kept in the order timers were linked into it, so timers scheduled on one frame for the same frame fire in that order
+	static inline std::array<int32_t, slotCount> heads = [] {
+		std::array<int32_t, slotCount> empty{};
+		empty.fill(-1);
+		return empty;
+	}();
+	static inline std::array<int32_t, slotCount> tails = heads;
+	static inline uint64_t now = 0;
+
+	static uint64_t schedule(int frames, uint32_t interval, const luabridge::LuaRef& callback);
+	// frames as a delay of 1 to maxDelay, so zero and negative counts mean the next frame
+	static uint32_t delay(int frames);
+	static int slotFor(uint64_t due);
+	static void link(int32_t timer);
+	static void unlink(int32_t timer);
+	static void release(int32_t timer);
+	// re-places every timer of a higher level slot now that it is closer
+	static void cascade(int slot);
+};
+
+#endif //TIMERS_H
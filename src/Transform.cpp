@@ -0,0 +1,74 @@
+#include "Transform.h"
+
+#include "RigidBody.h"
+
+REGISTER_NATIVE_COMPONENT(Transform)
+
+uint32_t Transforms::add(Transform* owner) {
+	const auto slot = static_cast<uint32_t>(owners.size());
+	x.push_back(0.0f);
+	y.push_back(0.0f);
+	rotation.push_back(0.0f);
+	scaleX.push_back(1.0f);
+	scaleY.push_back(1.0f);
+	owners.push_back(owner);
+	bodies.push_back(nullptr);
+	return slot;
+}
+
+void Transforms::remove(uint32_t slot) {
+	const size_t last = owners.size() - 1;
+	if (slot != last) {
+		x[slot] = x[last];
+		y[slot] = y[last];
+		rotation[slot] = rotation[last];
+		scaleX[slot] = scaleX[last];
+		scaleY[slot] = scaleY[last];
+		owners[slot] = owners[last];
+		owners[slot]->slot = slot;
+		bodies[slot] = bodies[last];
+	}
+	x.pop_back();
+	y.pop_back();
+	rotation.pop_back();
+	scaleX.pop_back();
+	scaleY.pop_back();
+	owners.pop_back();
+	bodies.pop_back();
+}
+
+void Transforms::attachBody(const Actor* actor) {
+	const auto transforms = actor->componentsByType.find(ComponentTypes::Transform);
+	if (transforms == actor->componentsByType.end()) return;
+	const RigidBody* rb = nullptr;
+	if (const auto it = actor->componentsByType.find(ComponentTypes::Rigidbody); it != actor->componentsByType.end() && !it->second.empty()) {
+		rb = static_cast<const RigidBody*>(it->second.front());
+	}
+	for (const Component* transform : transforms->second) {
+		bodies[static_cast<const Transform*>(transform)->slot] = rb;
+	}
+}
+
+void Transforms::syncBodies() {
+	for (size_t i = 0; i < bodies.size(); i++) {
+		const RigidBody* rb = bodies[i];
+		if (!rb) continue;
+		const b2::Vec2 pos = rb->getPosition();
+		x[i] = pos.x;
+		y[i] = pos.y;
+		rotation[i] = rb->getRotation();
+	}
+}
+
+Transform::Transform() {
+	slot = Transforms::add(this);
+}
+
+void Transform::setPosition(b2::Vec2 pos) {
+	setX(pos.x);
+	setY(pos.y);
+}
+
+Transform::~Transform() {
+	Transforms::remove(slot);
+}
@@ -0,0 +1,72 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <cstdint>
+#include <vector>
+
+#include "NativeComponent.h"
+#include "SpatialIndex.h"
+
+class Transform;
+class RigidBody;
+
+// Position, rotation and scale of every Transform component, one array per field so systems that
+// only touch positions walk contiguous memory. Engine wide rather than owned by a scene since actors
+// are built before their scene exists and DontDestroy actors outlive it
+class Transforms {
+public:
+	static inline std::vector<float> x, y, rotation, scaleX, scaleY;
+	static inline std::vector<Transform*> owners;
+	// the Rigidbody of each slot's actor, nullptr if it has none
+	static inline std::vector<const RigidBody*> bodies;
+
+	static uint32_t add(Transform* owner);
+	// moves the last slot into the freed one, so slots are only stable while no transform is destroyed
+	static void remove(uint32_t slot);
+	// refreshes bodies for the actor's Transforms, whenever it is indexed or gains or loses a component
+	static void attachBody(const Actor* actor);
+	// copies the position and rotation of every actor's Rigidbody into its Transform, after the physics step
+	static void syncBodies();
+	static size_t size() { return owners.size(); }
+};
+
+// the fields live in Transforms, so the field table reaches them through the getters and setters
+class Transform : public NativeComponent<Transform> {
+public:
+	uint32_t slot;
+
+	Transform();
+	// a copy would share the slot and free it twice, clone makes a new one
+	Transform(const Transform&) = delete;
+	Transform& operator=(const Transform&) = delete;
+
+	[[nodiscard]] float getX() const { return Transforms::x[slot]; }
+	[[nodiscard]] float getY() const { return Transforms::y[slot]; }
+	[[nodiscard]] float getRotation() const { return Transforms::rotation[slot]; }
+	[[nodiscard]] float getScaleX() const { return Transforms::scaleX[slot]; }
+	[[nodiscard]] float getScaleY() const { return Transforms::scaleY[slot]; }
+	void setX(float v) { Transforms::x[slot] = v; SpatialIndex::markMoved(actor); }
+	void setY(float v) { Transforms::y[slot] = v; SpatialIndex::markMoved(actor); }
+	void setRotation(float v) { Transforms::rotation[slot] = v; }
+	void setScaleX(float v) { Transforms::scaleX[slot] = v; }
+	void setScaleY(float v) { Transforms::scaleY[slot] = v; }
+	[[nodiscard]] b2::Vec2 getPosition() const { return {getX(), getY()}; }
+	void setPosition(b2::Vec2 pos);
+	~Transform() override;
+
+	static constexpr auto fields() {
+		return std::make_tuple(
+			field("x", &Transform::getX, &Transform::setX),
+			field("y", &Transform::getY, &Transform::setY),
+			field("rotation", &Transform::getRotation, &Transform::setRotation),
+			field("scale_x", &Transform::getScaleX, &Transform::setScaleX),
+			field("scale_y", &Transform::getScaleY, &Transform::setScaleY));
+	}
+
+	template <typename Class> static void bindFunctions(Class& cls) {
+		cls.addFunction("GetPosition", &Transform::getPosition);
+		cls.addFunction("SetPosition", &Transform::setPosition);
+	}
+};
+
+#endif //TRANSFORM_H
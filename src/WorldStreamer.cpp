@@ -0,0 +1,301 @@
+#include "WorldStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+#include "scene.hpp"
+#include "serializer.h"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+	bool byUUID(const Actor* a, const Actor* b) {
+		return a->uuid < b->uuid;
+	}
+
+	bool belowUUID(const Actor* a, size_t id) {
+		return a->uuid < id;
+	}
+
+	Actor* findActor(Scene& scene, size_t id) {
+		const auto it = std::lower_bound(scene.actors.begin(), scene.actors.end(), id, belowUUID);
+		if (it == scene.actors.end() || (*it)->uuid != id) return nullptr;
+		return *it;
+	}
+
+	// actors are kept sorted by id, and actors coming back from memory keep their old id
+	void insertActor(Scene& scene, Actor* actor) {
+		scene.actors.insert(std::upper_bound(scene.actors.begin(), scene.actors.end(), actor, byUUID), actor);
+		scene.indexActor(actor);
+	}
+
+	// unlike Scene::destroyActor this is immediate and doesn't run OnDestroy, the actor isn't gone for good.
+	// Its components are deleted, the actor itself is kept so lua references to it never dangle
+	void unloadActor(Scene& scene, Actor* actor) {
+		const auto it = std::lower_bound(scene.actors.begin(), scene.actors.end(), actor, byUUID);
+		if (it != scene.actors.end() && *it == actor) scene.actors.erase(it);
+		scene.unindexActor(actor);
+		scene.spatial.remove(actor);
+		for (const auto& [key, component] : actor->components) {
+			component->onDestroyed = nullptr;
+			delete component;
+		}
+		actor->components.clear();
+		actor->componentsByKey.clear();
+		actor->componentsByType.clear();
+		actor->addedThisFrame.clear();
+		actor->removedThisFrame.clear();
+		actor->streamedOut = true;
+	}
+
+	void writeActorDesc(Serializer& serial, const ActorDesc& desc) {
+		serial.writeString(desc.name);
+		serial.writeString(desc.templateName);
+		serial.writeBool(desc.hasPosition);
+		serial.writeFloat(desc.x);
+		serial.writeFloat(desc.y);
+		serial.writeSizeT(desc.tags.size());
+		for (const std::string& tag : desc.tags) serial.writeString(tag);
+		serial.writeSizeT(desc.components.size());
+		for (const ComponentDesc& comp : desc.components) {
+			serial.writeString(comp.key);
+			serial.writeString(comp.type);
+			serial.writeSizeT(comp.properties.size());
+			for (const PropertyDesc& p : comp.properties) {
+				serial.writeString(p.name);
+				serial.writeChar(p.kind);
+				switch (p.kind) {
+					case PropertyDesc::String: serial.writeString(p.string); break;
+					case PropertyDesc::Int: serial.writeInt(p.integer); break;
+					case PropertyDesc::Float: serial.writeFloat(p.number); break;
+					case PropertyDesc::Bool: serial.writeBool(p.boolean); break;
+				}
+			}
+		}
+	}
+
+	ActorDesc readActorDesc(Deserializer& serial) {
+		ActorDesc desc;
+		desc.name = serial.readString();
+		desc.templateName = serial.readString();
+		desc.hasPosition = serial.readBool();
+		desc.x = serial.readFloat();
+		desc.y = serial.readFloat();
+		desc.tags.resize(serial.readSizeT());
+		for (std::string& tag : desc.tags) tag = serial.readString();
+		desc.components.resize(serial.readSizeT());
+		for (ComponentDesc& comp : desc.components) {
+			comp.key = serial.readString();
+			comp.type = serial.readString();
+			comp.properties.resize(serial.readSizeT());
+			for (PropertyDesc& p : comp.properties) {
+				p.name = serial.readString();
+				p.kind = static_cast<PropertyDesc::Kind>(serial.readChar());
+				switch (p.kind) {
+					case PropertyDesc::String: p.string = serial.readString(); break;
+					case PropertyDesc::Int: p.integer = serial.readInt(); break;
+					case PropertyDesc::Float: p.number = serial.readFloat(); break;
+					case PropertyDesc::Bool: p.boolean = serial.readBool(); break;
+					default: throw SerialError("Corrupted save file");
+				}
+			}
+		}
+		// kinds and native field ids are looked up again, they can differ between builds
+		resolveActorDesc(desc);
+		return desc;
+	}
+}
+
+void WorldStreamer::configure(const StreamingDesc& streaming, std::vector<ActorDesc> streamed) {
+	clear();
+	settings = streaming;
+	if (!settings.enabled()) return;
+	for (ActorDesc& desc : streamed) {
+		float x = 0.0f, y = 0.0f;
+		desc.findPosition(x, y);
+		cells[cellKey(cellOf(x), cellOf(y))].descs.push_back(std::move(desc));
+	}
+	// cells are built from the back, keep the scene file order within a cell
+	for (auto& [key, cell] : cells) {
+		std::reverse(cell.descs.begin(), cell.descs.end());
+	}
+}
+
+int WorldStreamer::cellOf(float v) const {
+	return static_cast<int>(std::floor(v / settings.cellSize));
+}
+
+uint64_t WorldStreamer::cellKey(int x, int y) {
+	return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y);
+}
+
+void WorldStreamer::update(Scene& scene) {
+	if (!settings.enabled()) return;
+	const int cameraX = cellOf(scene.cameraPos.x);
+	const int cameraY = cellOf(scene.cameraPos.y);
+	unloadDistant(scene, cameraX, cameraY);
+
+	// nearest cells first so a tight budget still fills in the view from the middle out
+	const auto start = Clock::now();
+	for (int ring = 0; ring <= settings.loadRadius; ring++) {
+		for (int y = cameraY - ring; y <= cameraY + ring; y++) {
+			for (int x = cameraX - ring; x <= cameraX + ring; x++) {
+				if (std::max(std::abs(x - cameraX), std::abs(y - cameraY)) != ring) continue;
+				const auto it = cells.find(cellKey(x, y));
+				if (it == cells.end() || it->second.empty()) continue;
+				const bool inBudget = loadCell(scene, it->second, start);
+				if (it->second.empty()) cells.erase(it);
+				if (!inBudget) return;
+			}
+		}
+	}
+}
+
+void WorldStreamer::unloadDistant(Scene& scene, int cameraX, int cameraY) {
+	std::vector<size_t> kept;
+	kept.reserve(resident.size());
+	for (const size_t id : resident) {
+		Actor* actor = findActor(scene, id);
+		// destroyed by a script, or marked to outlive the scene and so no longer streamed
+		if (!actor || actor->dontDestroy) continue;
+
+		b2::Vec2 pos;
+		if (!actor->findPosition(pos)) {
+			kept.push_back(id);
+			continue;
+		}
+		const int cellX = cellOf(pos.x), cellY = cellOf(pos.y);
+		if (std::max(std::abs(cellX - cameraX), std::abs(cellY - cameraY)) <= settings.unloadRadius) {
+			kept.push_back(id);
+			continue;
+		}
+
+		std::ostringstream stream;
+		Serializer serial(stream);
+		serial.writeActor(actor);
+		cells[cellKey(cellX, cellY)].saved.push_back({stream.str(), saveVersion, actor->uuid, actor, actor->serialize});
+		unloadActor(scene, actor);
+	}
+	std::swap(resident, kept);
+}
+
+bool WorldStreamer::loadCell(Scene& scene, Cell& cell, Clock::time_point startTime) {
+	if (!cell.saved.empty()) {
+		std::vector<Reference> relocTable;
+		for (const SavedActor& saved : cell.saved) {
+			std::istringstream stream(saved.data);
+			Deserializer serial(stream);
+			serial.version = saved.version;
+			Actor* actor = serial.readActor(relocTable, saved.shell);
+			actor->streamedOut = false;
+			insertActor(scene, actor);
+			resident.push_back(actor->uuid);
+		}
+		// references to actors that are still unloaded come back as nil
+		scene.resolveRelocTable(relocTable);
+		cell.saved.clear();
+	}
+	while (!cell.descs.empty()) {
+		const ActorDesc& desc = cell.descs.back();
+		auto* actor = new Actor(desc);
+		actor->uuid = ++Actor::lastUUID;
+		scene.actors.push_back(actor);
+		scene.indexActor(actor);
+		resident.push_back(actor->uuid);
+		cell.descs.pop_back();
+
+		const std::chrono::duration<double, std::milli> elapsed = Clock::now() - startTime;
+		if (elapsed.count() >= frameBudget) return false;
+	}
+	return true;
+}
+
+Actor* WorldStreamer::forget(size_t uuid) {
+	for (auto it = cells.begin(); it != cells.end(); ++it) {
+		std::vector<SavedActor>& saved = it->second.saved;
+		const auto found = std::find_if(saved.begin(), saved.end(), [uuid](const SavedActor& s) { return s.uuid == uuid; });
+		if (found == saved.end()) continue;
+		Actor* shell = found->shell;
+		saved.erase(found);
+		if (it->second.empty()) cells.erase(it);
+		return shell;
+	}
+	return nullptr;
+}
+
+void WorldStreamer::clear() {
+	for (auto& [key, cell] : cells) {
+		for (const SavedActor& saved : cell.saved) {
+			delete saved.shell;
+		}
+	}
+	cells.clear();
+	resident.clear();
+}
+
+void WorldStreamer::write(Serializer& serial) const {
+	serial.writeFloat(settings.cellSize);
+	serial.writeInt(settings.loadRadius);
+	serial.writeInt(settings.unloadRadius);
+	serial.writeSizeT(resident.size());
+	for (const size_t id : resident) serial.writeSizeT(id);
+	serial.writeSizeT(cells.size());
+	for (const auto& [key, cell] : cells) {
+		serial.writeSizeT(key);
+		serial.writeSizeT(cell.descs.size());
+		for (const ActorDesc& desc : cell.descs) writeActorDesc(serial, desc);
+		serial.writeSizeT(cell.saved.size());
+		for (const SavedActor& saved : cell.saved) {
+			serial.writeSizeT(saved.uuid);
+			serial.writeBool(saved.serialize);
+			serial.writeBytes(saved.data);
+		}
+	}
+}
+
+void WorldStreamer::read(Deserializer& serial) {
+	clear();
+	settings.cellSize = serial.readFloat();
+	settings.loadRadius = serial.readInt();
+	settings.unloadRadius = serial.readInt();
+	resident.resize(serial.readSizeT());
+	for (size_t& id : resident) id = serial.readSizeT();
+	const size_t count = serial.readSizeT();
+	for (size_t i = 0; i < count; i++) {
+		Cell& cell = cells[serial.readSizeT()];
+		cell.descs.resize(serial.readSizeT());
+		for (ActorDesc& desc : cell.descs) desc = readActorDesc(serial);
+		cell.saved.resize(serial.readSizeT());
+		for (SavedActor& saved : cell.saved) {
+			saved.uuid = serial.readSizeT();
+			saved.serialize = serial.readBool();
+			saved.data = serial.readBytes();
+			saved.version = serial.version;
+		}
+	}
+}
+
+// the data is copied as it is, so only actors already in the current format can go into a new save. Others
+// come from a save state of an older format and are left out until they stream in and are written again
+static bool copiedToSaves(const WorldStreamer::SavedActor& saved) {
+	return saved.serialize && saved.version == saveVersion;
+}
+
+size_t WorldStreamer::savedActorCount() const {
+	size_t count = 0;
+	for (const auto& [key, cell] : cells) {
+		count += std::count_if(cell.saved.begin(), cell.saved.end(), copiedToSaves);
+	}
+	return count;
+}
+
+void WorldStreamer::writeSavedActors(Serializer& serial) const {
+	for (const auto& [key, cell] : cells) {
+		for (const SavedActor& saved : cell.saved) {
+			if (copiedToSaves(saved)) serial.writeRaw(saved.data);
+		}
+	}
+}
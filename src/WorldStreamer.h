@@ -0,0 +1,76 @@
+#ifndef WORLDSTREAMER_H
+#define WORLDSTREAMER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SceneDesc.h"
+
+class Scene;
+class Actor;
+class Serializer;
+class Deserializer;
+
+// Splits the positioned actors of a scene with a "streaming" block into square cells.
+// Cells near the camera are built, actors that end up far away are written to memory
+// in the save file actor format and unloaded until the camera comes back. An unloaded
+// actor stays allocated as a shell without components, see Actor::streamedOut
+class WorldStreamer {
+public:
+	void configure(const StreamingDesc& streaming, std::vector<ActorDesc> streamed);
+	// called once per frame with the autosave lock held, before onStart
+	void update(Scene& scene);
+	[[nodiscard]] bool enabled() const { return settings.enabled(); }
+	[[nodiscard]] size_t residentCount() const { return resident.size(); }
+	// drops an unloaded actor so it never streams back in, when a script destroys it or a save replaces it.
+	// Returns its shell, which the caller deletes, or null
+	Actor* forget(size_t uuid);
+	// deletes the shells of unloaded actors, for scene teardown
+	void clear();
+
+	// the streamer as part of a save state: settings, which actors came from cells, and every cell not loaded
+	void write(Serializer& serial) const;
+	void read(Deserializer& serial);
+	// unloaded actors marked for saving, for the saves that only hold those
+	[[nodiscard]] size_t savedActorCount() const;
+	void writeSavedActors(Serializer& serial) const;
+
+	// milliseconds per frame spent bringing cells in
+	static inline double frameBudget = 2.0;
+
+	struct SavedActor {
+		// the actor in the Serializer actor format, of the given save format version
+		std::string data;
+		int version = 0;
+		size_t uuid = 0;
+		// what it is filled back into, null for actors restored from a save since no script can hold those yet
+		Actor* shell = nullptr;
+		bool serialize = false;
+	};
+
+private:
+	struct Cell {
+		// actors from the scene file that were never built
+		std::vector<ActorDesc> descs;
+		// actors that were unloaded
+		std::vector<SavedActor> saved;
+
+		[[nodiscard]] bool empty() const { return descs.empty() && saved.empty(); }
+	};
+
+	StreamingDesc settings;
+	std::unordered_map<uint64_t, Cell> cells;
+	// ids of the built actors that came from cells
+	std::vector<size_t> resident;
+
+	[[nodiscard]] int cellOf(float v) const;
+	static uint64_t cellKey(int x, int y);
+	void unloadDistant(Scene& scene, int cameraX, int cameraY);
+	// returns false once the frame budget is used up
+	bool loadCell(Scene& scene, Cell& cell, std::chrono::steady_clock::time_point startTime);
+};
+
+#endif //WORLDSTREAMER_H
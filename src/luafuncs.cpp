@@ -12,6 +12,7 @@
 #include "ParticleSystem.h"
 #include "Rendering.h"
 #include "scene.hpp"
+#include "SceneLoader.h"
 #include "serializer.h"
 
 #include "Box2D/Box2D.hpp"
@@ -23,6 +24,15 @@ using namespace std;
 
 #include "raycasting.h"
 #include "EventBus.h"
+#include "NativeComponents.h"
+#include "Coroutines.h"
+#include "Timers.h"
+#include "ScriptCache.h"
+#include "MemoryStats.h"
+#include "FastBindings.h"
+#include "ParallelLanes.h"
+#include "LuaAllocator.h"
+#include "FrameArena.h"
 
 using namespace luabridge;
 
@@ -36,15 +46,83 @@ void cppLogError(const string& message) {
 
 const string componentBase = "resources/component_types/";
 
-void loadLuaFiles() {
+// component types that have not been run yet in lazy mode, by name
+unordered_map<string, filesystem::path> unloadedComponentTypes;
+
+// L is the thread that asked for the types, which can be a coroutine
+void runComponentTypes(lua_State* L, const vector<filesystem::path>& files) {
+    for (const ScriptCache::Script& script : ScriptCache::compile(files)) {
+        if (ScriptCache::load(L, script) != LUA_OK || lua_pcall(L, 0, 0, 0) != LUA_OK) {
+            cout << "problem with lua file " << script.path.stem().string();
+            exit(0);
+        }
+        ParallelLanes::loadType(L, script);
+        Serializer::addToExcludeSet(script.path.stem().string());
+        ComponentTypes::id(script.path.stem().string());
+    }
+}
+
+// __index of the global table in lazy mode, so reading a component type's global the first time runs its
+// file. Covers the engine looking a type up as well as scripts that refer to other types
+int loadComponentTypeOnRead(lua_State* L) {
+    if (lua_type(L, 2) == LUA_TSTRING) {
+        const auto it = unloadedComponentTypes.find(lua_tostring(L, 2));
+        if (it != unloadedComponentTypes.end()) {
+            const filesystem::path file = it->second;
+            unloadedComponentTypes.erase(it);
+            runComponentTypes(L, {file});
+            if (unloadedComponentTypes.empty()) {
+                lua_pushnil(L);
+                lua_setmetatable(L, 1);
+            }
+            lua_pushvalue(L, 2);
+            lua_rawget(L, 1);
+            return 1;
+        }
+    }
+    lua_pushnil(L);
+    return 1;
+}
+
+void loadLuaFiles(bool lazy) {
     if (std::filesystem::exists(componentBase)) {
+        vector<filesystem::path> files;
         for (const auto& file : filesystem::directory_iterator(componentBase)) {
-            if (luaL_dofile(luaState, file.path().string().c_str()) != LUA_OK) {
-                cout << "problem with lua file " << file.path().stem().string();
-                exit(0);
-            }
-            Serializer::addToExcludeSet(file.path().stem().string());
+            files.push_back(file.path());
+        }
+        if (!lazy) {
+            runComponentTypes(luaState, files);
+            return;
         }
+        for (const filesystem::path& file : files) {
+            unloadedComponentTypes.emplace(file.stem().string(), file);
+        }
+        if (unloadedComponentTypes.empty()) return;
+        lua_pushglobaltable(luaState);
+        lua_newtable(luaState);
+        lua_pushcfunction(luaState, loadComponentTypeOnRead);
+        lua_setfield(luaState, -2, "__index");
+        lua_setmetatable(luaState, -2);
+        lua_pop(luaState, 1);
+    }
+}
+
+void prefetchComponentTypes(const vector<string>& types) {
+    vector<filesystem::path> files;
+    for (const string& type : types) {
+        const auto it = unloadedComponentTypes.find(type);
+        if (it == unloadedComponentTypes.end()) continue;
+        files.push_back(it->second);
+        unloadedComponentTypes.erase(it);
+    }
+    if (files.empty()) return;
+    // compiled together so a cold cache is parsed in parallel
+    runComponentTypes(luaState, files);
+    if (unloadedComponentTypes.empty()) {
+        lua_pushglobaltable(luaState);
+        lua_pushnil(luaState);
+        lua_setmetatable(luaState, -2);
+        lua_pop(luaState, 1);
     }
 }
 
@@ -99,6 +177,7 @@ void saveState(const string& saveFile) {
 }
 
 void loadState(const string& saveFile) {
+    SceneLoader::cancel();
     std::filesystem::create_directory(savesPath);
     Scene::globalSceneRef->nextScene = savesPath+saveFile;
     Scene::globalSceneRef->loadedSave = true;
@@ -115,7 +194,8 @@ void saveScene(const string& saveFile, const LuaRef& previewData) {
     try {
         Serializer serial(savesPath+saveFile);
 
-        size_t count = 0;
+        // actors in unloaded cells of a streaming scene are saved too
+        size_t count = Scene::globalSceneRef->streamer.savedActorCount();
         for (Actor* act : Scene::globalSceneRef->actors) {
             if (act->serialize) {
                 count++;
@@ -134,6 +214,7 @@ void saveScene(const string& saveFile, const LuaRef& previewData) {
                 serial.writeActor(act);
             }
         }
+        Scene::globalSceneRef->streamer.writeSavedActors(serial);
     }
     catch (SerialError& e) {
         cerr << e.what() << endl;
@@ -147,7 +228,7 @@ void autosaveThread(const string& saveFile) {
         try {
             Serializer serial(savesPath+saveFile);
             autosaving_mutex.lock_shared();
-            size_t count = 0;
+            size_t count = Scene::globalSceneRef->streamer.savedActorCount();
 
             for (Actor* act : Scene::globalSceneRef->actors) {
                 if (act->serialize) {
@@ -160,6 +241,7 @@ void autosaveThread(const string& saveFile) {
                     serial.writeActor(act);
                 }
             }
+            Scene::globalSceneRef->streamer.writeSavedActors(serial);
 
             autosaving_mutex.unlock_shared();
         }
@@ -184,12 +266,136 @@ float b2Distance(const b2::Vec2& a, const b2::Vec2& b)
     return c.Length();
 }
 
+// in place versions of the Vector2 operators, which each create a new vector
+void b2Set(b2::Vec2* v, float x, float y)
+{
+    v->x = x;
+    v->y = y;
+}
+
+void b2AddInPlace(b2::Vec2* v, const b2::Vec2& other)
+{
+    *v += other;
+}
+
+void b2SubInPlace(b2::Vec2* v, const b2::Vec2& other)
+{
+    *v -= other;
+}
+
+void b2ScaleInPlace(b2::Vec2* v, float scale)
+{
+    *v *= scale;
+}
+
+int loadImageByName(const string& name) {
+    return loadImage(renderer, name);
+}
+
+// the ById functions take what Image.Load, Audio.Load, Text.LoadFont and Input.KeyCode return,
+// the plain ones keep taking names only. A negative id would fall through to the name lookup with an
+// empty name, so it is rejected here the way the lookups reject ids past the end
+static AssetRef assetById(int id, const char* kind) {
+    if (id < 0) {
+        std::cout << "error: invalid " << kind << " id " << id;
+        exit(0);
+    }
+    return {id, {}};
+}
+
+void drawUIById(int image, int x, int y) {
+    drawUI(assetById(image, "image"), x, y);
+}
+
+void drawUIExById(int image, float x, float y, float r, float g, float b, float a, int order) {
+    drawUIEx(assetById(image, "image"), x, y, r, g, b, a, order);
+}
+
+void drawImageById(int image, float x, float y) {
+    drawImage(assetById(image, "image"), x, y);
+}
+
+void drawImageExById(int image, float x, float y, float rotation, float scaleX, float scaleY, float pivotX, float pivotY, float r, float g, float b, float a, int order) {
+    drawImageEx(assetById(image, "image"), x, y, rotation, scaleX, scaleY, pivotX, pivotY, r, g, b, a, order);
+}
+
+void drawTextById(const string& text, int x, int y, int font, float r, float g, float b, float a) {
+    drawText(text, x, y, assetById(font, "font"), 0, r, g, b, a);
+}
+
+void playAudioById(int channel, int clip, bool loop) {
+    Audio::playAudio(channel, assetById(clip, "audio clip"), loop);
+}
+
+// -1 is what Input.KeyCode returns for a name that is no key, such a key is never down
+bool getKeyById(int key) {
+    return key >= 0 && InputManager::getKey({key, {}});
+}
+
+bool getKeyDownById(int key) {
+    return key >= 0 && InputManager::getKeyDown({key, {}});
+}
+
+bool getKeyUpById(int key) {
+    return key >= 0 && InputManager::getKeyUp({key, {}});
+}
+
+int getMousePositionXY(lua_State* L) {
+    const glm::vec2 pos = InputManager::getMousePosition();
+    return MemoryStats::pushXY(L, {pos.x, pos.y});
+}
+
+LuaRef getMemoryStats() {
+    LuaRef stats = newTable(luaState);
+    stats["lua_kb"] = lua_gc(luaState, LUA_GCCOUNT, 0) + lua_gc(luaState, LUA_GCCOUNTB, 0) / 1024.0;
+    stats["vectors_avoided"] = MemoryStats::vectorsAvoided;
+    if (const LuaAllocator* allocator = LuaAllocator::of(luaState)) {
+        // small blocks: pool_kb carved from the system, free_kb of it sitting in free lists, waste_kb lost to
+        // rounding up to a size class. Free and waste over pool is how fragmented the lua heap is
+        size_t freeBytes = 0;
+        size_t blockBytes = 0;
+        LuaRef classes = newTable(luaState);
+        for (size_t i = 0; i < LuaAllocator::classCount; i++) {
+            const LuaAllocator::SizeClass& sizeClass = allocator->classes[i];
+            const size_t size = (i + 1) * LuaAllocator::granularity;
+            freeBytes += (sizeClass.reserved - sizeClass.inUse) * size;
+            blockBytes += sizeClass.inUse * size;
+            LuaRef entry = newTable(luaState);
+            entry["size"] = size;
+            entry["in_use"] = sizeClass.inUse;
+            entry["free"] = sizeClass.reserved - sizeClass.inUse;
+            entry["allocations"] = sizeClass.allocations;
+            classes[i + 1] = entry;
+        }
+        stats["pool_kb"] = allocator->chunkBytes / 1024.0;
+        stats["free_kb"] = freeBytes / 1024.0;
+        stats["waste_kb"] = (blockBytes - allocator->requestedSmall) / 1024.0;
+        stats["large_kb"] = allocator->largeBytes / 1024.0;
+        stats["size_classes"] = classes;
+    }
+    stats["frame_arena_kb"] = FrameArena::capacity() / 1024.0;
+    stats["frame_arena_peak_kb"] = FrameArena::peak() / 1024.0;
+    LuaRef pools = newTable(luaState);
+    for (const ObjectPools::Entry& entry : ObjectPools::pools) {
+        const PoolStats pool = entry.stats();
+        LuaRef info = newTable(luaState);
+        info["live"] = pool.live;
+        info["capacity"] = pool.capacity;
+        info["slabs"] = pool.slabs;
+        info["kb"] = pool.bytes / 1024.0;
+        pools[entry.name] = info;
+    }
+    stats["object_pools"] = pools;
+    return stats;
+}
+
 /**
  *
  * @param saveFile The file to save to
  * @param scene The scene to use as a base
  */
 void loadSceneWithFile(const string& saveFile, const string& scene) {
+    SceneLoader::cancel();
     std::filesystem::create_directory(savesPath);
     Scene::globalSceneRef->nextScene2 = savesPath+saveFile;
     Scene::globalSceneRef->nextScene = scene;
@@ -198,6 +404,7 @@ void loadSceneWithFile(const string& saveFile, const string& scene) {
 }
 
 void loadSceneCurrent(const string& saveFile) {
+    SceneLoader::cancel();
     std::filesystem::create_directory(savesPath);
     Scene::globalSceneRef->nextScene = savesPath+saveFile;
     Scene::globalSceneRef->loadedSave = true;
@@ -231,6 +438,8 @@ void initializeGlobalFunctions() {
     getGlobalNamespace(luaState)
         .beginNamespace("Text")
         .addFunction("Draw", drawText)
+        .addFunction("DrawById", drawTextById)
+        .addFunction("LoadFont", loadFont)
         .endNamespace();
     getGlobalNamespace(luaState)
         .beginClass<b2::Vec2>("Vector2")
@@ -242,6 +451,10 @@ void initializeGlobalFunctions() {
         .addFunction("__add", &b2::Vec2::operatorAdd)
         .addFunction("__sub", &b2::Vec2::operatorSub)
         .addFunction("__mul", &b2::Vec2::operatorMul)
+        .addFunction("Set", &b2Set)
+        .addFunction("AddInPlace", &b2AddInPlace)
+        .addFunction("SubInPlace", &b2SubInPlace)
+        .addFunction("ScaleInPlace", &b2ScaleInPlace)
         .addStaticFunction("Dot", static_cast<float(*)(const b2::Vec2&, const b2::Vec2&)>(&b2Dot))
         .addStaticFunction("Distance", &b2Distance)
         .endClass();
@@ -254,6 +467,13 @@ void initializeGlobalFunctions() {
         .addFunction("GetComponents", &Actor::getComponentTypeAll)
         .addFunction("AddComponent", &Actor::addComponent)
         .addFunction("RemoveComponent", &Actor::removeComponent)
+        .addFunction("GetPosition", &Actor::getPosition)
+        .addFunction("SetPosition", &Actor::setPosition)
+        .addFunction("GetPositionXY", &Actor::getPositionXY)
+        .addFunction("SetPositionXY", &Actor::setPositionXY)
+        .addFunction("AddTag", &Actor::addTag)
+        .addFunction("RemoveTag", &Actor::removeTag)
+        .addFunction("HasTag", &Actor::hasTag)
         .endClass()
         .beginClass<glm::vec2>("vec2")
         .addProperty("x", &glm::vec2::x)
@@ -292,6 +512,13 @@ void initializeGlobalFunctions() {
         .addFunction("SetPosition", &RigidBody::setPosition)
         .addFunction("SetRotation", &RigidBody::setRotation)
         .addFunction("SetAngularVelocity", &RigidBody::setAngularVelocity)
+        .addFunction("GetPositionXY", &RigidBody::getPositionXY)
+        .addFunction("GetVelocityXY", &RigidBody::getVelocityXY)
+        .addFunction("GetUpDirectionXY", &RigidBody::getUpDirectionXY)
+        .addFunction("GetRightDirectionXY", &RigidBody::getRightDirectionXY)
+        .addFunction("SetPositionXY", &RigidBody::setPositionXY)
+        .addFunction("SetVelocityXY", &RigidBody::setVelocityXY)
+        .addFunction("AddForceXY", &RigidBody::addForceXY)
         .endClass()
         .beginClass<Collision>("Collision")
         .addProperty("other", &Collision::other)
@@ -331,6 +558,9 @@ void initializeGlobalFunctions() {
         .beginNamespace("Actor")
         .addFunction("Find", Scene::getActorByName)
         .addFunction("FindAll", Scene::getAllActorByName)
+        .addFunction("FindInRadius", Scene::findInRadius)
+        .addFunction("FindInRect", Scene::findInRect)
+        .addFunction("FindByTags", Scene::findByTags)
         .addFunction("Destroy", Scene::destroyActor)
         .addFunction("Instantiate", Scene::createActor)
         .endNamespace();
@@ -340,13 +570,30 @@ void initializeGlobalFunctions() {
         .addFunction("Sleep", sleep)
         .addFunction("Quit", Quit)
         .addFunction("OpenURL", OpenURL)
+        .addFunction("StartCoroutine", &Coroutines::start)
+        .addFunction("StopCoroutine", &Coroutines::stop)
+        .addFunction("WaitFrames", &Coroutines::waitFrames)
+        .addFunction("WaitSeconds", &Coroutines::waitSeconds)
+        .addFunction("WaitForEvent", &Coroutines::waitForEvent)
+        .addFunction("WaitUntilPhysicsStep", &Coroutines::waitUntilPhysicsStep)
+        // the same wait, named like WaitForEvent
+        .addFunction("WaitForPhysicsStep", &Coroutines::waitUntilPhysicsStep)
+        .addFunction("After", &Timers::after)
+        .addFunction("Every", &Timers::every)
+        .addFunction("Cancel", &Timers::cancel)
+        .addFunction("GetMemoryStats", getMemoryStats)
         .endNamespace();
     getGlobalNamespace(luaState)
         .beginNamespace("Input")
         .addFunction("GetKey", InputManager::getKey)
         .addFunction("GetKeyDown", InputManager::getKeyDown)
         .addFunction("GetKeyUp", InputManager::getKeyUp)
+        .addFunction("GetKeyById", getKeyById)
+        .addFunction("GetKeyDownById", getKeyDownById)
+        .addFunction("GetKeyUpById", getKeyUpById)
+        .addFunction("KeyCode", InputManager::keyCode)
         .addFunction("GetMousePosition", InputManager::getMousePosition)
+        .addFunction("GetMousePositionXY", getMousePositionXY)
         .addFunction("GetMouseButton", InputManager::getMouseButton)
         .addFunction("GetMouseButtonDown", InputManager::getMouseButtonDown)
         .addFunction("GetMouseButtonUp", InputManager::getMouseButtonUp)
@@ -357,6 +604,8 @@ void initializeGlobalFunctions() {
     getGlobalNamespace(luaState)
         .beginNamespace("Audio")
         .addFunction("Play", Audio::playAudio)
+        .addFunction("PlayById", playAudioById)
+        .addFunction("Load", Audio::load)
         .addFunction("Halt", Audio::haltChannel)
         .addFunction("SetVolume", Audio::setVol)
         .endNamespace()
@@ -376,7 +625,12 @@ void initializeGlobalFunctions() {
         .addFunction("DrawUIEx", drawUIEx)
         .addFunction("Draw", drawImage)
         .addFunction("DrawEx", drawImageEx)
+        .addFunction("DrawUIById", drawUIById)
+        .addFunction("DrawUIExById", drawUIExById)
+        .addFunction("DrawById", drawImageById)
+        .addFunction("DrawExById", drawImageExById)
         .addFunction("DrawPixel", drawPixel)
+        .addFunction("Load", loadImageByName)
         .endNamespace();
     getGlobalNamespace(luaState)
         .beginNamespace("Camera")
@@ -389,14 +643,20 @@ void initializeGlobalFunctions() {
     getGlobalNamespace(luaState)
         .beginNamespace("Scene")
         .addFunction("Load", Scene::load)
+        .addFunction("LoadAsync", SceneLoader::loadAsync)
+        .addFunction("IsLoading", SceneLoader::isLoading)
+        .addFunction("GetLoadProgress", SceneLoader::getProgress)
         .addFunction("GetCurrent", Scene::getCurrent)
         .addFunction("DontDestroy", Scene::dontDestroy)
         .addFunction("SetActorSaving", &setActorSaving)
         .endNamespace()
         .beginNamespace("Event")
+        .addFunction("Topic", &Events::topic)
         .addFunction("Subscribe", &Events::subscribe)
+        .addFunction("SubscribeBatch", &Events::subscribeBatch)
         .addFunction("Unsubscribe", &Events::unsubscribe)
         .addFunction("Publish", &Events::publish)
+        .addFunction("PublishDeferred", &Events::publishDeferred)
         .endNamespace()
         .beginNamespace("Saving")
         .addFunction("SaveState", &saveState)
@@ -407,6 +667,9 @@ void initializeGlobalFunctions() {
         .addFunction("GetAllSaves", &getAllSaves)
         .addFunction("EnableAutosaving", &enableAutosaving)
         .endNamespace();
+    // after Actor and Vector2 so native components can expose them
+    NativeComponents::initialize(luaState);
+    registerFastBindings(luaState);
 }
 
 template<> struct std::hash<LuaRef> {
@@ -6,6 +6,8 @@
 #define LUAFUNCS_H
 
 #include <shared_mutex>
+#include <string>
+#include <vector>
 
 #include "lua.hpp"
 #include "LuaBridge.h"
@@ -20,7 +22,11 @@ luabridge::LuaRef getComponent(const std::string &str);
 
 luabridge::LuaRef getBaseComponent(const std::string& str);
 
-void loadLuaFiles();
+// runs every component type file, or with lazy only indexes them and runs each the first time its global is read
+void loadLuaFiles(bool lazy);
+
+// runs the not yet loaded component types among types, all at once
+void prefetchComponentTypes(const std::vector<std::string>& types);
 
 void establishInheritance(luabridge::LuaRef &instance, const luabridge::LuaRef &parent);
 
@@ -13,12 +13,20 @@
 #include "Audio.h"
 #include "EventBus.h"
 #include "InputManager.h"
+#include "SceneLoader.h"
 #include "serializer.h"
 
 #include "luafuncs.h"
 
 #include "lua.hpp"
 #include "RigidBody.h"
+#include "Transform.h"
+#include "SpriteRenderer.h"
+#include "Coroutines.h"
+#include "Timers.h"
+#include "ParallelLanes.h"
+#include "LuaAllocator.h"
+#include "FrameArena.h"
 
 using std::cout;
 using std::endl;
@@ -125,11 +133,13 @@ int main(int argc, char* argv[]) { // NOLINT main should return 0
     TTF_Init();
 
     // initialize LUA
-    luaState = luaL_newstate();
+    luaState = LuaAllocator::newState();
     luaL_openlibs(luaState);
 
     initializeGlobalFunctions();
-    loadLuaFiles();
+    // before the component types load, parallel types are also loaded into every lane
+    if (config.HasMember("parallel_lanes")) ParallelLanes::initialize(config["parallel_lanes"].GetInt());
+    loadLuaFiles(config.HasMember("lazy_component_types") && config["lazy_component_types"].GetBool());
     createDefaultParticle(renderer, "");
 
     // load scene
@@ -141,6 +151,8 @@ int main(int argc, char* argv[]) { // NOLINT main should return 0
 
     bool exitFlag = true;
     while (exitFlag) {
+        // everything taken from the arena last frame is dead by now
+        FrameArena::reset();
         SDL_SetRenderDrawColor(renderer, clearColor.r, clearColor.g, clearColor.b, SDL_ALPHA_OPAQUE);
         SDL_RenderClear(renderer);
         // main game loop
@@ -153,6 +165,8 @@ int main(int argc, char* argv[]) { // NOLINT main should return 0
             }
             InputManager::processEvent(&event);
         }
+        // build part of any scene being loaded in the background
+        SceneLoader::update(scene);
         // check for new scenes
         if (!scene.nextScene.empty()) {
             if (scene.loadedSave) {
@@ -182,15 +196,18 @@ int main(int argc, char* argv[]) { // NOLINT main should return 0
                     std::vector<Reference> relocTable;
                     for (size_t i = 0; i < num; ++i) {
                         Actor* act = serial.readActor(relocTable);
+                        // the saved version replaces an unloaded one too
+                        delete scene.streamer.forget(act->uuid);
                         luabridge::LuaRef actor = Scene::getActorByID(act->uuid);
                         if (!actor.isNil()) {
                             auto* a = actor.cast<Actor*>();
                             scene.actors.erase(std::find(scene.actors.begin(), scene.actors.end(), a));
-                            scene.actorsByName[a->name].erase(std::find(scene.actorsByName[a->name].begin(), scene.actorsByName[a->name].end(), a));
+                            scene.unindexActor(a);
+                            scene.spatial.remove(a);
                             delete a;
                         }
                         scene.actors.push_back(act);
-                        scene.actorsByName[act->name].push_back(act);
+                        scene.indexActor(act);
                     }
                     smoothSort(scene.actors, compActors);
                     scene.resolveRelocTable(relocTable);
@@ -204,15 +221,18 @@ int main(int argc, char* argv[]) { // NOLINT main should return 0
                     std::vector<Reference> relocTable;
                     for (size_t i = 0; i < num; ++i) {
                         Actor* act = serial.readActor(relocTable);
+                        // the saved version replaces an unloaded one too
+                        delete scene.streamer.forget(act->uuid);
                         luabridge::LuaRef actor = Scene::getActorByID(act->uuid);
                         if (!actor.isNil()) {
                             auto* a = actor.cast<Actor*>();
                             scene.actors.erase(std::find(scene.actors.begin(), scene.actors.end(), a));
-                            scene.actorsByName[a->name].erase(std::find(scene.actorsByName[a->name].begin(), scene.actorsByName[a->name].end(), a));
+                            scene.unindexActor(a);
+                            scene.spatial.remove(a);
                             delete a;
                         }
                         scene.actors.push_back(act);
-                        scene.actorsByName[act->name].push_back(act);
+                        scene.indexActor(act);
                     }
                     smoothSort(scene.actors, compActors);
                     scene.resolveRelocTable(relocTable);
@@ -234,19 +254,30 @@ int main(int argc, char* argv[]) { // NOLINT main should return 0
         }
         // actor processing
         autosaving_mutex.lock();
+        // bring in cells near the camera and unload far ones before anything new gets OnStart
+        scene.streamer.update(scene);
         scene.onStart();
         for (Actor* actor : scene.actors) {
             // actor updating
             actor->update();
         }
+        ParallelLanes::update();
+        Coroutines::update();
+        Timers::advance();
         for (Actor* actor : scene.actors) {
             actor->lateUpdate();
         }
 
         scene.afterFrame();
+        Events::deliverDeferred();
         Events::lateUpdate();
         if (RigidBody::world)
             RigidBody::world->Step(1.0f / 60.0f, 8, 3);
+        Transforms::syncBodies();
+        Coroutines::afterPhysicsStep();
+        RigidBody::markAwakeMoved();
+        scene.spatial.update();
+        SpriteRenderer::enqueue(scene);
         autosaving_mutex.unlock();
         // rendering
         scene.renderFrame();
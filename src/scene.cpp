@@ -19,6 +19,14 @@
 #include "ParticleSystem.h"
 #include "Rendering.h"
 #include "serializer.h"
+#include "SceneBinary.h"
+#include "NativeComponents.h"
+#include "Transform.h"
+#include "MemoryStats.h"
+#include "ParallelLanes.h"
+#include "Coroutines.h"
+#include "SceneLoader.h"
+#include "FrameArena.h"
 
 using rapidjson::Document;
 using rapidjson::SizeType;
@@ -46,37 +54,42 @@ void Scene::afterFrame(){
 	addedThisFrame.clear();
 
     std::sort(removedThisFrame.begin(), removedThisFrame.end(), comp);
-    // removes everything from output that isn't needed
-    std::vector<Actor*> output;
-    std::set_difference(actors.begin(), actors.end(), removedThisFrame.begin(), removedThisFrame.end(), std::back_inserter(output), comp);
-    std::swap(output, actors);
-    // now remove everything from search container
-    for (auto& container : actorsByName) {
-        auto& vec = container.second;
-        output.clear();
-        std::set_difference(vec.begin(), vec.end(), removedThisFrame.begin(), removedThisFrame.end(), std::back_inserter(output), comp);
-        std::swap(output, vec);
+    // removes destroyed actors in place rather than building a new list every frame
+    if (!removedThisFrame.empty()) {
+        actors.erase(std::remove_if(actors.begin(), actors.end(), [this](Actor* actor) {
+            return std::binary_search(removedThisFrame.begin(), removedThisFrame.end(), actor, comp);
+        }), actors.end());
     }
+    // destroyActor already took them out of the name lookup
     // all references to actor are removed, so delete the actors
     for (Actor* act : removedThisFrame) {
+        spatial.remove(act);
         delete act;
     }
     removedThisFrame.clear();
 }
 
-bool renderComp(const RenderRequest& a, const RenderRequest& b) {
-	return a.sortingOrder < b.sortingOrder;
+// draw order of a queue: by sorting order, then by when the request was made. Sorts indices in the frame
+// arena since std::stable_sort takes a heap buffer every call
+static FrameVector<uint32_t> drawOrder(const std::vector<RenderRequest>& queue) {
+	FrameVector<uint32_t> order(queue.size());
+	for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+	std::sort(order.begin(), order.end(), [&queue](uint32_t a, uint32_t b) {
+		if (queue[a].sortingOrder != queue[b].sortingOrder) return queue[a].sortingOrder < queue[b].sortingOrder;
+		return a < b;
+	});
+	return order;
 }
 
 void Scene::renderFrame() {
-	// sort scene render in order
-	std::stable_sort(renderQueue.begin(), renderQueue.end(), renderComp);
-	std::stable_sort(UIRenderQueue.begin(), UIRenderQueue.end(), renderComp);
 	SDL_RenderSetScale(renderer, ZOOMFACTOR, ZOOMFACTOR);
 
-	for (const RenderRequest& request : renderQueue) {
+	for (const uint32_t index : drawOrder(renderQueue)) {
+		const RenderRequest& request = renderQueue[index];
+		const TextureInfo& texture = TextureRegistry::get(request.texture);
 		SDL_FRect rect;
-		Helper::SDL_QueryTexture(request.texture, &rect.w, &rect.h);
+		rect.w = texture.width;
+		rect.h = texture.height;
 		int flip = SDL_FLIP_NONE;
 		if (request.scaleX < 0) flip = SDL_FLIP_HORIZONTAL;
 		if (request.scaleY < 0) flip = SDL_FLIP_VERTICAL;
@@ -91,38 +104,43 @@ void Scene::renderFrame() {
 
 		if (rect.x > WIDTH || rect.y > HEIGHT || rect.x + rect.w < 0 || rect.y + rect.h < 0) continue;
 
-		SDL_SetTextureColorMod(request.texture, request.r, request.g, request.b);
-		SDL_SetTextureAlphaMod(request.texture, request.a);
+		SDL_SetTextureColorMod(texture.texture, request.r, request.g, request.b);
+		SDL_SetTextureAlphaMod(texture.texture, request.a);
 
-		Helper::SDL_RenderCopyEx(0, "", renderer, request.texture, nullptr, &rect, request.rotation, &pivot, static_cast<SDL_RendererFlip>(flip));
+		Helper::SDL_RenderCopyEx(0, "", renderer, texture.texture, &texture.source, &rect, request.rotation, &pivot, static_cast<SDL_RendererFlip>(flip));
 
-		SDL_SetTextureColorMod(request.texture, 255, 255, 255);
-		SDL_SetTextureAlphaMod(request.texture, 255);
+		SDL_SetTextureColorMod(texture.texture, 255, 255, 255);
+		SDL_SetTextureAlphaMod(texture.texture, 255);
 	}
 
 	SDL_RenderSetScale(renderer, 1.0f, 1.0f);
 
-	for (const RenderRequest& request : UIRenderQueue) {
+	for (const uint32_t index : drawOrder(UIRenderQueue)) {
+		const RenderRequest& request = UIRenderQueue[index];
+		const TextureInfo& texture = TextureRegistry::get(request.texture);
 		SDL_FRect rect;
-		Helper::SDL_QueryTexture(request.texture, &rect.w, &rect.h);
+		rect.w = texture.width;
+		rect.h = texture.height;
 		rect.x = request.x;
 		rect.y = request.y;
 
-		SDL_SetTextureColorMod(request.texture, request.r, request.g, request.b);
-		SDL_SetTextureAlphaMod(request.texture, request.a);
+		SDL_SetTextureColorMod(texture.texture, request.r, request.g, request.b);
+		SDL_SetTextureAlphaMod(texture.texture, request.a);
 
-		Helper::SDL_RenderCopy(renderer, request.texture, nullptr, &rect);
+		Helper::SDL_RenderCopy(renderer, texture.texture, &texture.source, &rect);
 
-		SDL_SetTextureColorMod(request.texture, 255, 255, 255);
-		SDL_SetTextureAlphaMod(request.texture, 255);
+		SDL_SetTextureColorMod(texture.texture, 255, 255, 255);
+		SDL_SetTextureAlphaMod(texture.texture, 255);
 	}
 
 	for (const TextRequest& request : textRenderQueue) {
 		SDL_FRect rect;
 		rect.x = static_cast<float>(request.x);
 		rect.y = static_cast<float>(request.y);
-		Helper::SDL_QueryTexture(request.texture, &rect.w, &rect.h);
-		Helper::SDL_RenderCopy(renderer, request.texture, nullptr, &rect);
+		const TextureInfo& texture = TextureRegistry::get(request.texture);
+		rect.w = texture.width;
+		rect.h = texture.height;
+		Helper::SDL_RenderCopy(renderer, texture.texture, &texture.source, &rect);
 	}
 
 	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
@@ -154,12 +172,53 @@ void Scene::resolveRelocTable(std::vector<Reference> &relocTable) {
 	}
 }
 
+// keeps vec sorted by id, actors are mostly added in id order
+void insertSorted(vector<Actor*>& vec, Actor* actor) {
+	if (vec.empty() || vec.back()->uuid < actor->uuid) vec.push_back(actor);
+	else vec.insert(std::upper_bound(vec.begin(), vec.end(), actor, comp), actor);
+}
+
+void Scene::indexActor(Actor* actor) {
+	actor->nameId = NameTable::intern(actor->name);
+	actor->indexed = true;
+	NameBucket& bucket = actorsByName[actor->nameId];
+	insertSorted(bucket.actors, actor);
+	bucket.cache.reset();
+	for (uint64_t tags = actor->tags; tags; tags &= tags - 1) {
+		insertSorted(actorsByTag[glm::findLSB(tags)], actor);
+	}
+	Transforms::attachBody(actor);
+	SpatialIndex::markMoved(actor);
+}
+
+void Scene::unindexActor(Actor* actor) {
+	actor->indexed = false;
+	for (uint64_t tags = actor->tags; tags; tags &= tags - 1) {
+		unindexTag(actor, glm::findLSB(tags));
+	}
+	const auto it = actorsByName.find(actor->nameId);
+	if (it == actorsByName.end()) return;
+	auto& vec = it->second.actors;
+	if (const auto found = std::find(vec.begin(), vec.end(), actor); found != vec.end()) vec.erase(found);
+	if (vec.empty()) actorsByName.erase(it);
+	else it->second.cache.reset();
+}
+
+void Scene::indexTag(Actor* actor, int tag) {
+	insertSorted(actorsByTag[tag], actor);
+}
+
+void Scene::unindexTag(Actor* actor, int tag) {
+	auto& vec = actorsByTag[tag];
+	if (const auto found = std::find(vec.begin(), vec.end(), actor); found != vec.end()) vec.erase(found);
+}
+
 LuaRef Scene::getActorByName(const std::string& name) {
-	auto ref = LuaRef(luaState);
-	if (auto vecRef = globalSceneRef->actorsByName[name]; !vecRef.empty()) {
-	    ref = vecRef[0];
+	const auto it = globalSceneRef->actorsByName.find(NameTable::find(name));
+	if (it == globalSceneRef->actorsByName.end()) {
+		return {luaState};
 	}
-	return ref;
+	return {luaState, it->second.actors.front()};
 }
 
 bool finderComp(Actor* act, size_t id) {
@@ -200,44 +259,174 @@ LuaRef Scene::createActor(const std::string &templateName){
 	actor->uuid = Actor::lastUUID+1;
 	Actor::lastUUID++;
     globalSceneRef->addedThisFrame.push_back(actor);
-    globalSceneRef->actorsByName[actor->name].push_back(actor);
+    globalSceneRef->indexActor(actor);
     auto ref = LuaRef(luaState, actor);
     return ref;
 }
 
 void Scene::destroyActor(Actor* actor){
+	// an unloaded actor has no components, it only needs to be kept from streaming back in
+	if (actor->streamedOut) globalSceneRef->streamer.forget(actor->uuid);
     for (const auto& component : actor->components) {
         (component.second->first)["enabled"] = false;
     }
     globalSceneRef->removedThisFrame.push_back(actor);
 	// remove from search container
-	auto& ref = globalSceneRef->actorsByName[actor->name];
-	ref.erase(std::find(ref.begin(), ref.end(), actor));
+	globalSceneRef->unindexActor(actor);
 }
 
 LuaRef Scene::getAllActorByName(const std::string& name) {
+	const auto it = globalSceneRef->actorsByName.find(NameTable::find(name));
+	if (it == globalSceneRef->actorsByName.end()) {
+		return newTable(luaState);
+	}
+	NameBucket& bucket = it->second;
+	if (!bucket.cache) {
+		LuaRef table = newTable(luaState);
+		int counter = 1;
+		for (Actor* i : bucket.actors) {
+			table[counter] = i;
+			counter++;
+		}
+		bucket.cache = table;
+	}
+	// shared by every caller until the bucket changes, so FindAll allocates nothing on a repeated call
+	return *bucket.cache;
+}
+
+// turns spatial query results into a lua array, keeping only actors called name if one was given
+LuaRef spatialResults(const std::vector<Actor*>& found, const LuaRef& name) {
 	LuaRef table = newTable(luaState);
-    if (auto vecRef = globalSceneRef->actorsByName[name]; !vecRef.empty()) {
-        int counter = 1;
-        for (Actor* i : vecRef) {
-            table[counter] = i;
-            counter++;
-        }
-    }
+	const bool filter = name.isString();
+	const uint32_t wanted = filter ? NameTable::find(name.cast<string>()) : 0;
+	int counter = 1;
+	for (Actor* actor : found) {
+		if (filter && actor->nameId != wanted) continue;
+		table[counter] = actor;
+		counter++;
+	}
 	return table;
 }
 
-Scene::Scene(const std::string& filename) {
-	std::string path = basePath + filename;
-	name = filename.substr(0, filename.length() - 6);
+LuaRef Scene::findInRadius(float x, float y, float radius, const LuaRef& name) {
+	std::vector<Actor*> found;
+	globalSceneRef->spatial.queryRadius(x, y, radius, found);
+	return spatialResults(found, name);
+}
+
+LuaRef Scene::findInRect(float x, float y, float width, float height, const LuaRef& name) {
+	std::vector<Actor*> found;
+	globalSceneRef->spatial.queryRect(x, y, x + width, y + height, found);
+	return spatialResults(found, name);
+}
+
+// ors the bits of a lua array of tag names, or a single name, into mask. False if any name was never registered
+bool tagMask(const LuaRef& tags, uint64_t& mask) {
+	bool known = true;
+	auto add = [&](const LuaRef& tag) {
+		const int id = tag.isString() ? TagTable::find(tag.cast<string>()) : -1;
+		if (id < 0) known = false;
+		else mask |= TagTable::bit(id);
+	};
+	if (tags.isTable()) {
+		for (int i = 1; i <= tags.length(); i++) add(tags[i]);
+	}
+	else if (!tags.isNil()) add(tags);
+	return known;
+}
+
+LuaRef Scene::findByTags(const LuaRef& all, const LuaRef& any, const LuaRef& none) {
+	LuaRef table = newTable(luaState);
+	uint64_t allMask = 0, anyMask = 0, noneMask = 0;
+	// a required tag nobody was ever given, or only unknown optional ones, can't match anything
+	if (!tagMask(all, allMask)) return table;
+	if (!tagMask(any, anyMask) && anyMask == 0) return table;
+	tagMask(none, noneMask);
+	const auto matches = [&](const Actor* actor) {
+		return (actor->tags & allMask) == allMask && (anyMask == 0 || (actor->tags & anyMask)) && !(actor->tags & noneMask);
+	};
+
+	Scene& scene = *globalSceneRef;
+	int counter = 1;
+	if (allMask) {
+		// every match is in the list of each required tag, walk the shortest one
+		const vector<Actor*>* shortest = nullptr;
+		for (uint64_t bits = allMask; bits; bits &= bits - 1) {
+			const vector<Actor*>& list = scene.actorsByTag[glm::findLSB(bits)];
+			if (!shortest || list.size() < shortest->size()) shortest = &list;
+		}
+		for (Actor* actor : *shortest) {
+			if (!matches(actor)) continue;
+			table[counter] = actor;
+			counter++;
+		}
+	}
+	else if (anyMask) {
+		std::vector<Actor*> found;
+		for (uint64_t bits = anyMask; bits; bits &= bits - 1) {
+			const int tag = glm::findLSB(bits);
+			for (Actor* actor : scene.actorsByTag[tag]) {
+				// an actor with several of the tags is only taken from the list of its lowest one
+				if (glm::findLSB(actor->tags & anyMask) == tag && matches(actor)) found.push_back(actor);
+			}
+		}
+		std::sort(found.begin(), found.end(), comp);
+		for (Actor* actor : found) {
+			table[counter] = actor;
+			counter++;
+		}
+	}
+	else {
+		for (Actor* actor : scene.actors) {
+			if (!actor->indexed || !matches(actor)) continue;
+			table[counter] = actor;
+			counter++;
+		}
+	}
+	return table;
+}
+
+// reads the scene as descriptions if it is compiled or streamed, otherwise leaves the parsed json in doc
+bool readSceneFile(const std::string& path, const std::string& sceneName, Document& doc, SceneDesc& desc) {
+	if (hasCompiledScene(path) && readCompiledScene(compiledScenePath(path), "resources/actor_templates/", desc)) {
+		return true;
+	}
 	if (!std::filesystem::exists(path)) {
-		std::cout << "error: scene " + name + " is missing";
+		std::cout << "error: scene " + sceneName + " is missing";
 		exit(0);
 	}
-	Document doc;
 	ReadJsonFile(path, doc);
+	if (!doc.HasMember("streaming")) return false;
+	if (std::string error; !readSceneDesc(doc, "resources/actor_templates/", desc, error)) {
+		std::cout << error;
+		exit(0);
+	}
+	return true;
+}
 
-	auto& arr = doc["actors"];
+void Scene::buildActors(SceneDesc& desc) {
+	streamer.configure(desc.streaming, takeStreamedActors(desc));
+	std::vector<std::string> types;
+	for (const ActorDesc& actorDesc : desc.actors) {
+		for (const ComponentDesc& component : actorDesc.components) {
+			if (component.kind == ComponentKind::Lua) types.push_back(component.type);
+		}
+	}
+	prefetchComponentTypes(types);
+	for (const ActorDesc& actorDesc : desc.actors) {
+		auto* actor = new Actor(actorDesc);
+		actor->uuid = ++Actor::lastUUID;
+		actors.push_back(actor);
+		indexActor(actor);
+	}
+}
+
+Scene::Scene(const std::string& filename) {
+	std::string path = basePath + filename;
+	name = filename.substr(0, filename.length() - 6);
+	Document doc;
+	SceneDesc desc;
+	const bool useDesc = readSceneFile(path, name, doc, desc);
 
 	// create templates
 	string templatePath = "resources/actor_templates";
@@ -249,40 +438,64 @@ Scene::Scene(const std::string& filename) {
 		}
 	}
 
+	if (useDesc) {
+		buildActors(desc);
+		return;
+	}
+	auto& arr = doc["actors"];
 	for (unsigned int i = 0; i < arr.Size(); i++) {
 		// create actor
 		auto& obj = arr[i];
 	    auto* actor = new Actor(obj, templates);
 		actors.push_back(actor);
-		actorsByName[actor->name].push_back(actor);
+		indexActor(actor);
 	}
 }
 
 Scene::Scene(const std::string& filename, std::vector<Actor*>& acts, std::unordered_map<std::string, Actor>& temps) {
 	std::string path = basePath + filename;
 	name = filename.substr(0, filename.length() - 6);
-	if (!std::filesystem::exists(path)) {
-		std::cout << "error: scene " + name + " is missing";
-		exit(0);
-	}
 	Document doc;
-	ReadJsonFile(path, doc);
+	SceneDesc desc;
+	const bool useDesc = readSceneFile(path, name, doc, desc);
 	std::swap(templates, temps);
-	auto& arr = doc["actors"];
 	Actor::lastUUID = 0;
 	for (Actor* actor : acts) {
 		if (actor->dontDestroy) {
 			actors.push_back(actor);
-			actorsByName[actor->name].push_back(actor);
+			indexActor(actor);
 		}
 	}
 
+	if (useDesc) {
+		buildActors(desc);
+		return;
+	}
+	auto& arr = doc["actors"];
 	for (unsigned int i = 0; i < arr.Size(); i++) {
 		// create actor
 		auto& obj = arr[i];
 		auto* actor = new Actor(obj, templates);
 		actors.emplace_back(actor);
-		actorsByName[actor->name].push_back(actor);
+		indexActor(actor);
+	}
+}
+
+Scene::Scene(std::string sceneName, std::vector<Actor*>& acts, std::unordered_map<std::string, Actor>& temps, const std::vector<Actor*>& loaded)
+	: name(std::move(sceneName)) {
+	std::swap(templates, temps);
+	Actor::lastUUID = 0;
+	for (Actor* actor : acts) {
+		if (actor->dontDestroy) {
+			actors.push_back(actor);
+			indexActor(actor);
+		}
+	}
+	// actors were built ahead of time, so they only get their ids once the scene is swapped in
+	for (Actor* actor : loaded) {
+		actor->uuid = ++Actor::lastUUID;
+		actors.push_back(actor);
+		indexActor(actor);
 	}
 }
 
@@ -317,6 +530,12 @@ Actor::Actor(rapidjson::Value& json, std::unordered_map<std::string, Actor>& tem
 	if (auto it = json.FindMember("name"); it != end) {
 		name = it->value.GetString();
 	}
+	if (auto it = json.FindMember("position"); it != end) {
+		readPosition(it->value);
+	}
+	if (auto it = json.FindMember("tags"); it != end) {
+		readTags(it->value);
+	}
 	if (auto it = json.FindMember("components"); it != end) {
 		for (auto it2 = it->value.MemberBegin(); it2 != it->value.MemberEnd(); ++it2) {
 			// load component
@@ -329,38 +548,46 @@ Actor::Actor(rapidjson::Value& json, std::unordered_map<std::string, Actor>& tem
 			}
 			else {
 				// else get a new component of that type
-				if (strcmp(it2->value["type"].GetString(), "Rigidbody") == 0) {
+				const ComponentType typeId = ComponentTypes::id(it2->value["type"].GetString());
+				if (typeId == ComponentTypes::Rigidbody) {
 					auto* compone = new RigidBody();
 					components[it2->name.GetString()] = compone;
 					compone->first = compone;
 					componentsByKey[it2->name.GetString()] = compone;
-					componentsByType[it2->value["type"].GetString()].push_back(compone);
+					componentsByType[typeId].push_back(compone);
 					compone->initialized = false;
 					compone->actor = this;
 					compone->key = it2->name.GetString();
 					compone->enabled = true;
 					compon = compone;
 				}
-				else if (strcmp(it2->value["type"].GetString(), "ParticleSystem") == 0) {
+				else if (typeId == ComponentTypes::ParticleSystem) {
 					auto* compone = new ParticleSystem(it2->value);
 					compone->first = compone;
 					components[it2->name.GetString()] = compone;
 					componentsByKey[it2->name.GetString()] = compone;
-					componentsByType[it2->value["type"].GetString()].push_back(compone);
+					componentsByType[typeId].push_back(compone);
 					compone->initialized = false;
 					compone->actor = this;
 					compone->key = it2->name.GetString();
 					compone->enabled = true;
 					compon = compone;
 				}
+				else if (const NativeType* native = NativeComponents::find(typeId)) {
+					compon = native->create(this, it2->name.GetString());
+					ref = compon->first;
+					components[it2->name.GetString()] = compon;
+					componentsByKey[it2->name.GetString()] = compon;
+					componentsByType[typeId].push_back(compon);
+				}
 				else {
 					ref = getComponent(it2->value["type"].GetString());
 					compon = new Component();
 					components[it2->name.GetString()] = compon;
 					compon->first = ref;
 					componentsByKey[it2->name.GetString()] = compon;
-					componentsByType[it2->value["type"].GetString()].push_back(compon);
-					compon->type = it2->value["type"].GetString();
+					componentsByType[typeId].push_back(compon);
+					compon->type = typeId;
 					compon->initialized = false;
 					LuaRef start = compon->first["OnStart"];
 					if (start.isFunction()) compon->onStart = [](LuaRef ref) {
@@ -397,8 +624,8 @@ Actor::Actor(rapidjson::Value& json, std::unordered_map<std::string, Actor>& tem
 				}
 			}
 			// override member variables
-			if (compon->type == "Rigidbody") {
-				auto* rigid = dynamic_cast<RigidBody*>(compon);
+			if (compon->type == ComponentTypes::Rigidbody) {
+				auto* rigid = static_cast<RigidBody*>(compon);
 				if (auto it3 = it2->value.FindMember("x"); it3 != it2->value.MemberEnd()) {
 					rigid->x = it3->value.GetFloat();
 				}
@@ -459,9 +686,12 @@ Actor::Actor(rapidjson::Value& json, std::unordered_map<std::string, Actor>& tem
 				if (auto it3 = it2->value.FindMember("trigger_radius"); it3 != it2->value.MemberEnd()) {
 					rigid->triggerRadius = it3->value.GetFloat();
 				}
-			} else if (compon->type == "ParticleSystem") {
+			} else if (compon->type == ComponentTypes::ParticleSystem) {
 				// do nothing
 			}
+			else if (const NativeType* native = NativeComponents::find(compon->type)) {
+				native->loadJson(compon, it2->value);
+			}
 			else {
 				for (auto it3 = it2->value.MemberBegin(); it3 != it2->value.MemberEnd(); ++it3) {
 					if (strcmp(it3->name.GetString(), "type") != 0) {
@@ -488,6 +718,12 @@ Actor::Actor(rapidjson::Value& json) : uuid(lastUUID+1) {
 	if (auto it = json.FindMember("name"); it != end) {
 		name = it->value.GetString();
 	}
+	if (auto it = json.FindMember("position"); it != end) {
+		readPosition(it->value);
+	}
+	if (auto it = json.FindMember("tags"); it != end) {
+		readTags(it->value);
+	}
 	if (auto it = json.FindMember("components"); it != end) {
 		for (auto it2 = it->value.MemberBegin(); it2 != it->value.MemberEnd(); ++it2) {
 			// load component
@@ -500,38 +736,46 @@ Actor::Actor(rapidjson::Value& json) : uuid(lastUUID+1) {
 			}
 			else {
 				// else get a new component of that type
-				if (strcmp(it2->value["type"].GetString(), "Rigidbody") == 0) {
+				const ComponentType typeId = ComponentTypes::id(it2->value["type"].GetString());
+				if (typeId == ComponentTypes::Rigidbody) {
 					auto* compone = new RigidBody();
 					components[it2->name.GetString()] = compone;
 					compone->first = compone;
 					componentsByKey[it2->name.GetString()] = compone;
-					componentsByType[it2->value["type"].GetString()].push_back(compone);
+					componentsByType[typeId].push_back(compone);
 					compone->initialized = false;
 					compone->actor = this;
 					compone->key = it2->name.GetString();
 					compone->enabled = true;
 					compon = compone;
 				}
-				else if (strcmp(it2->value["type"].GetString(), "ParticleSystem") == 0) {
+				else if (typeId == ComponentTypes::ParticleSystem) {
 					auto* compone = new ParticleSystem(it2->value);
 					compone->first = compone;
 					components[it2->name.GetString()] = compone;
 					componentsByKey[it2->name.GetString()] = compone;
-					componentsByType[it2->value["type"].GetString()].push_back(compone);
+					componentsByType[typeId].push_back(compone);
 					compone->initialized = false;
 					compone->actor = this;
 					compone->key = it2->name.GetString();
 					compone->enabled = true;
 					compon = compone;
 				}
+				else if (const NativeType* native = NativeComponents::find(typeId)) {
+					compon = native->create(this, it2->name.GetString());
+					ref = compon->first;
+					components[it2->name.GetString()] = compon;
+					componentsByKey[it2->name.GetString()] = compon;
+					componentsByType[typeId].push_back(compon);
+				}
 				else {
 					ref = getComponent(it2->value["type"].GetString());
 					compon = new Component();
 					components[it2->name.GetString()] = compon;
 					compon->first = ref;
 					componentsByKey[it2->name.GetString()] = compon;
-					componentsByType[it2->value["type"].GetString()].push_back(compon);
-					compon->type = it2->value["type"].GetString();
+					componentsByType[typeId].push_back(compon);
+					compon->type = typeId;
 					compon->initialized = false;
 					LuaRef start = compon->first["OnStart"];
 					if (start.isFunction()) compon->onStart = [](LuaRef ref) {
@@ -568,8 +812,8 @@ Actor::Actor(rapidjson::Value& json) : uuid(lastUUID+1) {
 				}
 			}
 			// override member variables
-			if (compon->type == "Rigidbody") {
-				auto* rigid = dynamic_cast<RigidBody*>(compon);
+			if (compon->type == ComponentTypes::Rigidbody) {
+				auto* rigid = static_cast<RigidBody*>(compon);
 				if (auto it3 = it2->value.FindMember("x"); it3 != it2->value.MemberEnd()) {
 					rigid->x = it3->value.GetFloat();
 				}
@@ -630,9 +874,12 @@ Actor::Actor(rapidjson::Value& json) : uuid(lastUUID+1) {
 				if (auto it3 = it2->value.FindMember("trigger_radius"); it3 != it2->value.MemberEnd()) {
 					rigid->triggerRadius = it3->value.GetFloat();
 				}
-			} else if (compon->type == "ParticleSystem") {
+			} else if (compon->type == ComponentTypes::ParticleSystem) {
 				// do nothing cause it's already set
 			}
+			else if (const NativeType* native = NativeComponents::find(compon->type)) {
+				native->loadJson(compon, it2->value);
+			}
 			else {
 				for (auto it3 = it2->value.MemberBegin(); it3 != it2->value.MemberEnd(); ++it3) {
 					if (strcmp(it3->name.GetString(), "type") != 0) {
@@ -653,9 +900,135 @@ Actor::Actor(rapidjson::Value& json) : uuid(lastUUID+1) {
 	}
 }
 
+Actor::Actor(const ActorDesc& desc) : name(desc.name), position(desc.x, desc.y), hasPosition(desc.hasPosition) {
+	for (const std::string& tag : desc.tags) {
+		tags |= TagTable::bit(TagTable::id(tag));
+	}
+	for (const ComponentDesc& comp : desc.components) {
+		Component* compon;
+		if (comp.kind == ComponentKind::Rigidbody) {
+			auto* rigid = new RigidBody();
+			rigid->first = rigid;
+			rigid->actor = this;
+			rigid->key = comp.key;
+			rigid->enabled = true;
+			rigid->applyDesc(comp);
+			compon = rigid;
+		}
+		else if (comp.kind == ComponentKind::ParticleSystem) {
+			auto* ps = new ParticleSystem();
+			ps->first = ps;
+			ps->actor = this;
+			ps->key = comp.key;
+			ps->enabled = true;
+			ps->applyDesc(comp);
+			compon = ps;
+		}
+		else if (const NativeType* native = NativeComponents::find(ComponentTypes::find(comp.type))) {
+			compon = native->create(this, comp.key);
+			native->loadDesc(compon, comp);
+		}
+		else {
+			compon = new Component();
+			compon->first = getComponent(comp.type);
+			compon->type = ComponentTypes::id(comp.type);
+			compon->bindLuaCallbacks();
+			LuaRef& ref = compon->first;
+			for (const PropertyDesc& p : comp.properties) {
+				switch (p.kind) {
+					case PropertyDesc::String:
+						ref[p.name] = p.string;
+						break;
+					case PropertyDesc::Int:
+						ref[p.name] = p.integer;
+						break;
+					case PropertyDesc::Float:
+						ref[p.name] = p.number;
+						break;
+					case PropertyDesc::Bool:
+						ref[p.name] = p.boolean;
+						break;
+				}
+			}
+			ref["key"] = comp.key;
+			ref["enabled"] = true;
+			ref["actor"] = this;
+		}
+		compon->initialized = false;
+		components[comp.key] = compon;
+		componentsByKey[comp.key] = compon;
+		componentsByType[compon->type].push_back(compon);
+	}
+}
+
+void Actor::readPosition(const rapidjson::Value& json) {
+	hasPosition = true;
+	if (auto x = json.FindMember("x"); x != json.MemberEnd()) position.x = x->value.GetFloat();
+	if (auto y = json.FindMember("y"); y != json.MemberEnd()) position.y = y->value.GetFloat();
+}
+
+bool Actor::findPosition(b2::Vec2& out) const {
+	if (const auto it = componentsByType.find(ComponentTypes::Rigidbody); it != componentsByType.end() && !it->second.empty()) {
+		out = static_cast<const RigidBody*>(it->second.front())->getPosition();
+		return true;
+	}
+	if (const auto it = componentsByType.find(ComponentTypes::Transform); it != componentsByType.end() && !it->second.empty()) {
+		out = static_cast<const Transform*>(it->second.front())->getPosition();
+		return true;
+	}
+	out = position;
+	return hasPosition;
+}
+
+b2::Vec2 Actor::getPosition() const {
+	b2::Vec2 pos;
+	findPosition(pos);
+	return pos;
+}
+
+void Actor::setPosition(b2::Vec2 pos) {
+	position = pos;
+	hasPosition = true;
+	SpatialIndex::markMoved(this);
+}
+
+int Actor::getPositionXY(lua_State* L) {
+	return MemoryStats::pushXY(L, getPosition());
+}
+
+void Actor::setPositionXY(float x, float y) {
+	setPosition({x, y});
+	MemoryStats::vectorsAvoided++;
+}
+
+void Actor::addTag(const std::string& tag) {
+	const int id = TagTable::id(tag);
+	if (tags & TagTable::bit(id)) return;
+	tags |= TagTable::bit(id);
+	if (indexed) Scene::globalSceneRef->indexTag(this, id);
+}
+
+void Actor::removeTag(const std::string& tag) {
+	const int id = TagTable::find(tag);
+	if (id < 0 || !(tags & TagTable::bit(id))) return;
+	tags &= ~TagTable::bit(id);
+	if (indexed) Scene::globalSceneRef->unindexTag(this, id);
+}
+
+bool Actor::hasTag(const std::string& tag) const {
+	const int id = TagTable::find(tag);
+	return id >= 0 && (tags & TagTable::bit(id));
+}
+
+void Actor::readTags(const rapidjson::Value& json) {
+	for (unsigned int i = 0; i < json.Size(); i++) {
+		tags |= TagTable::bit(TagTable::id(json[i].GetString()));
+	}
+}
+
 LuaRef Actor::getComponentType(const std::string& key) {
 	LuaRef ref(luaState);
-	if (auto it = componentsByType.find(key); it != componentsByType.end() && !it->second.empty()) {
+	if (auto it = componentsByType.find(ComponentTypes::find(key)); it != componentsByType.end() && !it->second.empty()) {
 		ref = it->second[0]->first;
 	}
 	return ref;
@@ -679,9 +1052,10 @@ Component * Actor::getCompPointerByKey(const std::string &key) {
 
 LuaRef Actor::getComponentTypeAll(const std::string& key) {
 	LuaRef ref = newTable(luaState);
-    auto component = componentsByType[key];
+	const auto it = componentsByType.find(ComponentTypes::find(key));
+	if (it == componentsByType.end()) return ref;
     int counter = 1;
-    for (const auto i : component) {
+    for (const auto i : it->second) {
         ref[counter] = i->first;
         counter++;
     }
@@ -690,37 +1064,45 @@ LuaRef Actor::getComponentTypeAll(const std::string& key) {
 
 LuaRef Actor::addComponent(const std::string &type){
     static int componentsAdded = 0;
-	std::ostringstream key;
-    key << 'r' << componentsAdded;
-	if (type == "Rigidbody") {
+	const std::string key = 'r' + std::to_string(componentsAdded);
+	const ComponentType typeId = ComponentTypes::id(type);
+	if (typeId == ComponentTypes::Rigidbody) {
 		auto* rb = new RigidBody();
-		rb->key = key.str();
+		rb->key = key;
 		rb->enabled = true;
 		rb->initialized = false;
-		componentsByKey[key.str()] = rb;
-		componentsByType[type].push_back(rb);
+		componentsByKey[key] = rb;
+		componentsByType[typeId].push_back(rb);
 		addedThisFrame.push_back(rb);
 		rb->first = rb;
 		rb->actor = this;
 		return rb->first;
 	}
-	if (type == "ParticleSystem") {
+	if (typeId == ComponentTypes::ParticleSystem) {
 		auto* ps = new ParticleSystem();
-		ps->key = key.str();
+		ps->key = key;
 		ps->initialized = false;
-		componentsByKey[key.str()] = ps;
-		componentsByType[type].push_back(ps);
+		componentsByKey[key] = ps;
+		componentsByType[typeId].push_back(ps);
 		addedThisFrame.push_back(ps);
 		ps->first = ps;
 		ps->actor = this;
 		return ps->first;
 	}
+	if (const NativeType* native = NativeComponents::find(typeId)) {
+		Component* compon = native->create(this, key);
+		componentsByKey[key] = compon;
+		componentsByType[typeId].push_back(compon);
+		addedThisFrame.push_back(compon);
+		componentsAdded++;
+		return compon->first;
+	}
 	auto* newComponent = new Component();
     newComponent->first = getComponent(type);
     
-    (newComponent->first)["key"] = key.str();
+    (newComponent->first)["key"] = key;
 	newComponent->initialized = false;
-	newComponent->type = type;
+	newComponent->type = typeId;
 	(newComponent->first)["enabled"] = true;
 	(newComponent->first)["actor"] = this;
 	LuaRef start = newComponent->first["OnStart"];
@@ -757,10 +1139,13 @@ LuaRef Actor::addComponent(const std::string &type){
 		};
 
 
-    componentsByKey[key.str()] = newComponent;
-    componentsByType[type].push_back(newComponent);
+    componentsByKey[key] = newComponent;
+    componentsByType[typeId].push_back(newComponent);
     addedThisFrame.push_back(newComponent);
 	componentsAdded++;
+	// a new Transform or Rigidbody takes over the position
+	Transforms::attachBody(this);
+	SpatialIndex::markMoved(this);
     return newComponent->first;
 }
 
@@ -775,6 +1160,8 @@ void Actor::removeComponent(const LuaRef& component) {
 	component["enabled"] = false;
     auto& vec = componentsByType[removedThisFrame.back()->type];
     vec.erase(std::find(vec.begin(), vec.end(), removedThisFrame.back()));
+	Transforms::attachBody(this);
+	SpatialIndex::markMoved(this);
 }
 
 void Scene::onStart() {
@@ -805,6 +1192,7 @@ string Scene::getCurrent() {
 }
 
 void Scene::load(const std::string& newScene) {
+	SceneLoader::cancel();
 	globalSceneRef->nextScene = newScene;
 }
 
@@ -815,25 +1203,65 @@ Scene::~Scene() {
 			delete actor;
 		}
 	}
+	streamer.clear();
+	// the scene's actors and components are gone, give their empty slabs back
+	ObjectPools::trimAll();
 }
 
 Scene& Scene::operator=(const Scene& other) {
 	actors = other.actors;
 	actorsByName = other.actorsByName;
+	actorsByTag = other.actorsByTag;
 	name = other.name;
 	nextScene = "";
 	cameraPos = other.cameraPos;
 	templates = other.templates;
+	streamer = other.streamer;
+	spatial = other.spatial;
 	return *this;
 }
 
+bool Actor::throttle(Component* component, bool& positioned, float& distanceSq) {
+	if (!component->policyRead) component->readUpdatePolicy();
+	if (!component->policy.active) return true;
+	if (distanceSq < 0.0f) {
+		// worked out once per actor per frame, and only if one of its components has a policy
+		b2::Vec2 pos;
+		positioned = findPosition(pos);
+		const float dx = pos.x - Scene::globalSceneRef->cameraPos.x;
+		const float dy = pos.y - Scene::globalSceneRef->cameraPos.y;
+		distanceSq = dx * dx + dy * dy;
+	}
+	const UpdatePolicy& policy = component->policy;
+	component->framesSinceTick++;
+	bool tick = true;
+	if (positioned) {
+		if (policy.suspendRadiusSq > 0.0f && distanceSq > policy.suspendRadiusSq) tick = false;
+		else if (distanceSq > policy.fullRateRadiusSq) tick = component->framesSinceTick >= policy.interval;
+	}
+	component->tickThisFrame = tick;
+	return tick;
+}
+
 void Actor::update() {
-	
+	bool positioned = false;
+	float distanceSq = -1.0f;
     for (auto& componentPair : components) {
         LuaRef& component = componentPair.second->first;
+		// nothing to throttle or tell about skipped frames
+		if (!componentPair.second->onUpdate && !componentPair.second->onLateUpdate) continue;
+		if (!throttle(componentPair.second, positioned, distanceSq)) continue;
 		try {
-			if ((component)["enabled"] && componentPair.second->onUpdate) {
-				(componentPair.second->onUpdate)(component);
+			if (!(component)["enabled"]) continue;
+			// only written when a callback is about to run, so disabled components cost no table write.
+			// frames spent disabled count towards the next delta
+			if (componentPair.second->policy.active) {
+				component["delta_frames"] = componentPair.second->framesSinceTick;
+				componentPair.second->framesSinceTick = 0;
+			}
+			if (componentPair.second->onUpdate) {
+				if (componentPair.second->parallel) ParallelLanes::schedule(this, componentPair.second);
+				else (componentPair.second->onUpdate)(component);
 			}
 		}
 		catch (const LuaException& e) {
@@ -845,6 +1273,7 @@ void Actor::update() {
 void Actor::lateUpdate() {
     for (auto& componentPair : components) {
         LuaRef& component = componentPair.second->first;
+		if (componentPair.second->policy.active && !componentPair.second->tickThisFrame) continue;
 		try {
 			if ((component)["enabled"] && componentPair.second->onLateUpdate) {
 				(componentPair.second->onLateUpdate)(component);
@@ -873,6 +1302,9 @@ void Actor::lateUpdate() {
 
 Actor::Actor(const Actor& other) {
 	name = other.name;
+	position = other.position;
+	hasPosition = other.hasPosition;
+	tags = other.tags;
 	for (const auto& component : other.components) {
 		auto* compon = component.second->clone();
 		compon->first["actor"] = this;
@@ -881,9 +1313,8 @@ Actor::Actor(const Actor& other) {
 	for (auto& pair : components) {
 	    Component* ref = pair.second;
 		string key = (ref->first)["key"];
-		string type = ref->type;
 		componentsByKey[key] = ref;
-	    componentsByType[type].push_back(ref);
+	    componentsByType[ref->type].push_back(ref);
 	}
 }
 
@@ -893,10 +1324,14 @@ Actor& Actor::operator=(const Actor &other){
     std::swap(componentsByKey, act.componentsByKey);
     std::swap(componentsByType, act.componentsByType);
     std::swap(name, act.name);
+    position = act.position;
+    hasPosition = act.hasPosition;
+    tags = act.tags;
     return *this;
 }
 
 Actor::~Actor(){
+    SpatialIndex::forget(this);
     for (auto&[fst, snd] : components) {
         delete snd;
     }
@@ -925,13 +1360,64 @@ Component* Component::clone() {
 	return new Component(*this);
 }
 
+void Component::bindLuaCallbacks() {
+	if (first["OnStart"].isFunction()) onStart = [](LuaRef ref) {
+		ref["OnStart"](ref);
+		};
+	if (first["OnUpdate"].isFunction()) onUpdate = [](LuaRef ref) {
+		ref["OnUpdate"](ref);
+		};
+	if (first["OnLateUpdate"].isFunction()) onLateUpdate = [](LuaRef ref) {
+		ref["OnLateUpdate"](ref);
+		};
+	if (first["OnDestroy"].isFunction()) onDestroyed = [](LuaRef ref) {
+		ref["OnDestroy"](ref);
+		};
+	if (first["OnCollisionEnter"].isFunction()) onCollisionEnter = [](LuaRef ref, Collision& col) {
+		ref["OnCollisionEnter"](ref, col);
+		};
+	if (first["OnCollisionExit"].isFunction()) onCollisionExit = [](LuaRef ref, Collision& col) {
+		ref["OnCollisionExit"](ref, col);
+		};
+	if (first["OnTriggerEnter"].isFunction()) onTriggerEnter = [](LuaRef ref, Collision& col) {
+		ref["OnTriggerEnter"](ref, col);
+		};
+	if (first["OnTriggerExit"].isFunction()) onTriggerExit = [](LuaRef ref, Collision& col) {
+		ref["OnTriggerExit"](ref, col);
+		};
+}
+
+void Component::readUpdatePolicy() {
+	policyRead = true;
+	if (!first.isTable()) return;
+	parallel = ParallelLanes::enabled() && first["parallel"].isBool() && first["parallel"].cast<bool>();
+	const LuaRef declared = first["update_policy"];
+	if (!declared.isTable()) return;
+	policy.active = true;
+	if (const LuaRef radius = declared["full_rate_radius"]; radius.isNumber()) {
+		policy.fullRateRadiusSq = radius.cast<float>() * radius.cast<float>();
+	}
+	if (const LuaRef radius = declared["suspend_radius"]; radius.isNumber()) {
+		policy.suspendRadiusSq = radius.cast<float>() * radius.cast<float>();
+	}
+	if (const LuaRef interval = declared["interval"]; interval.isNumber()) {
+		policy.interval = std::max(1, interval.cast<int>());
+	}
+}
+
 void Component::serialize(Serializer &serial) {
 	serial.writeTable(first);
 }
 
 
 Component::~Component() {
+	if (parallel) ParallelLanes::release(this);
 	if (onDestroyed) onDestroyed(first);
+	if (Coroutines::anyOwned() && first.isTable()) {
+		first.push();
+		Coroutines::stopOwnedBy(lua_topointer(first.state(), -1));
+		lua_pop(first.state(), 1);
+	}
 }
 
 void Component::kindaADestructor() const {
@@ -1,10 +1,12 @@
 #ifndef SCENE_HPP
 #define SCENE_HPP
 
+#include <array>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <iostream>
+#include <optional>
 
 #include "../glm/glm.hpp"
 #include "SDL_render.h"
@@ -31,6 +33,15 @@
 
 #include "SDL_mixer.h"
 
+#include "SceneDesc.h"
+#include "WorldStreamer.h"
+#include "SpatialIndex.h"
+#include "NameTable.h"
+#include "ComponentTypes.h"
+#include "TagTable.h"
+#include "ObjectPool.h"
+#include "TextureRegistry.h"
+
 struct Reference;
 class Deserializer;
 class Serializer;
@@ -54,25 +65,6 @@ inline void setZoom(float zoom) {
 	HALFHZOOM = ZOOMINVERSE * HALFHEIGHT;
 }
 
-inline void ReadJsonFile(const std::string& path, rapidjson::Document& out_document)
-{
-	FILE* file_pointer = nullptr;
-#ifdef _WIN32
-	fopen_s(&file_pointer, path.c_str(), "rb");
-#else
-	file_pointer = fopen(path.c_str(), "rb");
-#endif
-	char buffer[65536];
-	rapidjson::FileReadStream stream(file_pointer, buffer, sizeof(buffer));
-	out_document.ParseStream(stream);
-	std::fclose(file_pointer);
-
-	if (out_document.HasParseError()) {
-		std::cout << "error parsing json at [" << path << "]" << std::endl;
-		exit(0);
-	}
-}
-
 inline void ReportError (const std::string& name, const luabridge::LuaException& e) {
 	std::string errorMessage = e.what();
 
@@ -99,13 +91,23 @@ struct HitResult {
 		: actor(actor), point(point), normal(normal), isTrigger(isTrigger) {}
 };
 
+// declared by a lua component type as update_policy = { full_rate_radius, interval, suspend_radius }
+// full rate near the camera, every interval frames past full_rate_radius, not at all past suspend_radius
+struct UpdatePolicy {
+	float fullRateRadiusSq = 0.0f;
+	// 0 means the component is never suspended
+	float suspendRadiusSq = 0.0f;
+	int interval = 1;
+	bool active = false;
+};
+
 typedef void (*lifecycleFunction) (luabridge::LuaRef);
 typedef void (*collisionFunction) (luabridge::LuaRef, Collision&);
 
 class Component {
 public:
 	luabridge::LuaRef first;
-    std::string type = "Rigidbody";
+    ComponentType type = ComponentTypes::Rigidbody;
     lifecycleFunction onStart = nullptr;
     lifecycleFunction onUpdate = nullptr;
     lifecycleFunction onLateUpdate = nullptr;
@@ -115,12 +117,22 @@ public:
 	collisionFunction onTriggerEnter = nullptr;
 	collisionFunction onTriggerExit = nullptr;
 	bool initialized = false;
+	UpdatePolicy policy;
+	bool policyRead = false;
+	// set by Actor::update for throttled components, lateUpdate follows the same decision
+	bool tickThisFrame = true;
+	int framesSinceTick = 0;
+	// declared by a lua component type as parallel = true, OnUpdate then runs in a ParallelLanes lane
+	bool parallel = false;
 	Component();
 	Component(const Component& other);
 	virtual Component* clone();
 	virtual void serialize(Serializer& serial);
+	void bindLuaCallbacks();
+	void readUpdatePolicy();
     void kindaADestructor() const;
 	virtual ~Component();
+	POOLED_OBJECT(Component)
 };
 
 
@@ -129,21 +141,48 @@ class Actor {
 public:
 	std::map<std::string, Component*> components;
 	std::unordered_map<std::string, Component*> componentsByKey;
-	std::unordered_map<std::string, std::vector<Component*>> componentsByType;
+	std::unordered_map<ComponentType, std::vector<Component*>> componentsByType;
 	std::vector<Component*> addedThisFrame, removedThisFrame;
 	std::string name;
+	// interned name, assigned when the actor is added to its scene's name lookup
+	uint32_t nameId = 0;
+	// one bit per TagTable tag
+	uint64_t tags = 0;
+	// whether the actor is in its scene's name and tag lookups, so tag changes update them
+	bool indexed = false;
+	// queued in SpatialIndex's moved list
+	bool spatialMoved = false;
 	unsigned long long uuid = 0;
+	// explicit position from the scene file or Actor:SetPosition, a rigidbody or transform takes priority over it
+	b2::Vec2 position;
+	bool hasPosition = false;
 	bool dontDestroy = false;
+	// unloaded by the scene's WorldStreamer. The actor is kept as a shell without components so lua
+	// references to it stay valid, and is filled in again when its cell streams back in
+	bool streamedOut = false;
 	bool serialize = false;
 
 	static unsigned long long lastUUID;
 	Actor(rapidjson::Value& json, std::unordered_map<std::string, Actor>& templates);
 	explicit Actor(rapidjson::Value& json);
+	explicit Actor(const ActorDesc& desc);
 
 	void update();
 	void lateUpdate();
+	void readPosition(const rapidjson::Value& json);
+	// applies the update policy of a component, false if it skips this frame
+	bool throttle(Component* component, bool& positioned, float& distanceSq);
 	[[nodiscard]] size_t getUUID() const { return uuid; }
 	[[nodiscard]] std::string getName() const {return name;}
+	bool findPosition(b2::Vec2& out) const;
+	[[nodiscard]] b2::Vec2 getPosition() const;
+	void setPosition(b2::Vec2 pos);
+	int getPositionXY(lua_State* L);
+	void setPositionXY(float x, float y);
+	void addTag(const std::string& tag);
+	void removeTag(const std::string& tag);
+	[[nodiscard]] bool hasTag(const std::string& tag) const;
+	void readTags(const rapidjson::Value& json);
 	luabridge::LuaRef getComponentByKey(const std::string& key);
 	Component* getCompPointerByKey(const std::string& key);
 	luabridge::LuaRef getComponentType(const std::string& key);
@@ -157,28 +196,29 @@ public:
 	Actor(const Actor& other);
 	Actor& operator=(const Actor& other);
 	~Actor();
+	POOLED_OBJECT(Actor)
 };
 
 // REQUEST TYPE: 0=scene-space, 1=UI, 2=text, 3=pixels
 struct RenderRequest {
-	SDL_Texture* texture;
+	TextureId texture;
 	float x, y;
 	float scaleX, scaleY;
 	float rotation;
 	float pivotX, pivotY;
 	int sortingOrder;
 	uint8_t r, g, b, a;
-	RenderRequest(SDL_Texture* t, float x, float y, float sx, float sy, float rot, float px, float py, int order, uint8_t r, uint8_t g, uint8_t b, uint8_t a) :
+	RenderRequest(TextureId t, float x, float y, float sx, float sy, float rot, float px, float py, int order, uint8_t r, uint8_t g, uint8_t b, uint8_t a) :
 	texture(t), x(x), y(y), scaleX(sx), scaleY(sy), rotation(rot), pivotX(px), pivotY(py), sortingOrder(order),
 	r(r), g(g), b(b), a(a) {}
 
-	RenderRequest(SDL_Texture* t, float x, float y) :
+	RenderRequest(TextureId t, float x, float y) :
 	texture(t), x(x), y(y), scaleX(1.0f), scaleY(1.0f), rotation(0), pivotX(0.5f), pivotY(0.5f), sortingOrder(0),
 	r(255), g(255), b(255), a(255) {}
 };
 
 struct TextRequest {
-	SDL_Texture* texture;
+	TextureId texture;
 	int x, y;
 };
 
@@ -190,10 +230,20 @@ struct PointRequest {
 	}
 };
 
+// every actor with one name, sorted by id
+struct NameBucket {
+	std::vector<Actor*> actors;
+	// lua array handed out by Actor.FindAll, dropped whenever the bucket changes
+	std::optional<luabridge::LuaRef> cache;
+};
+
 class Scene {
 public:
 	std::unordered_map<std::string, Actor> templates;
-	std::unordered_map<std::string, std::vector<Actor*>> actorsByName;
+	// keyed by interned name, buckets are removed once empty
+	std::unordered_map<uint32_t, NameBucket> actorsByName;
+	// actors with each tag, sorted by id
+	std::array<std::vector<Actor*>, TagTable::maxTags> actorsByTag;
 	std::vector<Actor*> actors;
 	std::vector<Actor*> addedThisFrame;
 	std::vector<Actor*> removedThisFrame;
@@ -201,6 +251,8 @@ public:
 	std::vector<TextRequest> textRenderQueue;
 	std::vector<PointRequest> pointQueue;
 	glm::vec2 cameraPos = { 0, 0 };
+	WorldStreamer streamer;
+	SpatialIndex spatial;
 	std::string name;
 	std::string nextScene;
 	std::string nextScene2;
@@ -211,17 +263,27 @@ public:
 	void afterFrame();
 	void renderFrame();
 	void resolveRelocTable(std::vector<Reference>& relocTable);
+	void buildActors(SceneDesc& desc);
+	// adds an actor to the name and tag lookups
+	void indexActor(Actor* actor);
+	void unindexActor(Actor* actor);
+	void indexTag(Actor* actor, int tag);
+	void unindexTag(Actor* actor, int tag);
 	static luabridge::LuaRef getActorByName(const std::string& name);
 	static luabridge::LuaRef getActorByID(size_t id);
 	static luabridge::LuaRef createActor(const std::string& templateName);
 	static void destroyActor(Actor* actor);
 	static luabridge::LuaRef getAllActorByName(const std::string& name);
+	static luabridge::LuaRef findInRadius(float x, float y, float radius, const luabridge::LuaRef& name);
+	static luabridge::LuaRef findInRect(float x, float y, float width, float height, const luabridge::LuaRef& name);
+	static luabridge::LuaRef findByTags(const luabridge::LuaRef& all, const luabridge::LuaRef& any, const luabridge::LuaRef& none);
 	static void dontDestroy(Actor* actor);
 	static std::string getCurrent();
 	static void load(const std::string& newScene);
 	static Scene* globalSceneRef;
 	explicit Scene(const std::string& filename);
 	Scene(const std::string& filename, std::vector<Actor*>& acts, std::unordered_map<std::string, Actor>& temps);
+	Scene(std::string sceneName, std::vector<Actor*>& acts, std::unordered_map<std::string, Actor>& temps, const std::vector<Actor*>& loaded);
 	Scene() = default;
 	Scene& operator=(const Scene& other);
 	~Scene();
@@ -11,6 +11,7 @@
 #include "scene.hpp"
 #include "ParticleSystem.h"
 #include "RigidBody.h"
+#include "NativeComponents.h"
 
 inline bool is_big_endian() {
     union {
@@ -34,6 +35,14 @@ template <typename T> T swap_endian(T u) {
     return dest.u;
 }
 
+// Save files start with the magic and a format version. Saves from before the header have neither and are
+// read as version 0. Versions:
+// 1: actors carry their tags
+// 2: actors carry their explicit position
+// 3: save states carry the world streamer, with the actors of unloaded cells
+inline constexpr char saveMagic[4] = {'K', 'S', 'A', 'V'};
+inline constexpr int saveVersion = 3;
+
 struct Reference {
     luabridge::LuaRef ref;
     std::string component;
@@ -59,7 +68,9 @@ public:
 
 class Serializer {
     size_t current_pos;
-    std::ofstream file;
+    std::ofstream fileStream;
+    // either fileStream or a caller owned stream, such as a string buffer
+    std::ostream& file;
     inline static std::unordered_set<std::string> excludeSet = {"warn",
 "Event",
 "type",
@@ -199,19 +210,32 @@ public:
         current_pos += 8;
     }
 
+    // bytes that are already in this format, such as an actor written by another Serializer
+    void writeRaw(const std::string& data) {
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        current_pos += data.size();
+    }
+
+    // length prefixed bytes, unlike writeString they can contain zeros
+    void writeBytes(const std::string& data) {
+        writeSizeT(data.size());
+        writeRaw(data);
+    }
+
     // Function will recursively call writeTable if component is storing tables inside it
     void writeTable(const luabridge::LuaRef &ref) {
         assert(ref.type() == LUA_TTABLE);
         luabridge::Iterator it(ref);
         size_t count = 0;
         while (!it.isNil()) {
-            if (!it.value().isFunction() && !it.value().isNil()) count++;
+            // coroutines are never saved
+            if (!it.value().isFunction() && !it.value().isNil() && !it.value().isThread()) count++;
             ++it;
         }
         writeSizeT(count);
         it = luabridge::Iterator(ref);
         while (!it.isNil()) {
-            if (it.value().isFunction()) {
+            if (it.value().isFunction() || it.value().isThread()) {
                 ++it;
                 continue;
             }
@@ -224,7 +248,7 @@ public:
                     Actor* act = it.value()["actor"];
                     Component* c = act->getCompPointerByKey(it.value()["key"]);
                     writeChar(4);
-                    writeString(c->type);
+                    writeString(ComponentTypes::name(c->type));
                     writeSizeT(act->uuid);
                     writeString(it.value()["key"]);
                     ++it;
@@ -285,7 +309,7 @@ public:
     }
 
     void writeComponent(Component* component) {
-        writeString(component->type);
+        writeString(ComponentTypes::name(component->type));
         writeBool(component->initialized);
         component->serialize(*this);
     }
@@ -295,6 +319,13 @@ public:
         writeString(act->name);
         writeBool(act->dontDestroy);
         writeBool(act->serialize);
+        // tags by name, their bits depend on the order they were first used in
+        writeSizeT(glm::bitCount(act->tags));
+        for (uint64_t tags = act->tags; tags; tags &= tags - 1) {
+            writeString(TagTable::name(glm::findLSB(tags)));
+        }
+        writeBool(act->hasPosition);
+        writeVec2(act->position);
         writeSizeT(act->components.size());
         for (const auto&[fst, snd] : act->components) {
             writeString(fst);
@@ -310,6 +341,7 @@ public:
         for (const Actor* act : scene.actors) {
             writeActor(act);
         }
+        scene.streamer.write(*this);
     }
 
     void writeVec2(glm::vec2 vec) {
@@ -329,13 +361,13 @@ public:
         size_t count = 0;
         for (luabridge::Iterator it(global); !it.isNil(); ++it) {
             std::string key = it.key();
-            if (excludeSet.find(it.key().tostring()) == excludeSet.end()) {
+            if (excludeSet.find(it.key().tostring()) == excludeSet.end() && !it.value().isThread()) {
                 count++;
             }
         }
         writeSizeT(count);
         for (luabridge::Iterator it(global); !it.isNil(); ++it) {
-            if (it.value().isFunction()) {
+            if (it.value().isFunction() || it.value().isThread()) {
                 continue;
             }
             std::string s = it.key();
@@ -348,7 +380,7 @@ public:
                     Actor* act = it.value()["actor"];
                     Component* c = act->getCompPointerByKey(it.value()["key"]);
                     writeChar(4);
-                    writeString(c->type);
+                    writeString(ComponentTypes::name(c->type));
                     writeSizeT(act->uuid);
                     writeString(it.value()["key"]);
                     continue;
@@ -401,23 +433,31 @@ public:
         }
     }
 
-    explicit Serializer(const std::string& filename) : current_pos(0) {
-        file.open(filename, std::ios_base::binary);
-        if (!file.is_open()) {
+    explicit Serializer(const std::string& filename) : current_pos(0), file(fileStream) {
+        fileStream.open(filename, std::ios_base::binary);
+        if (!fileStream.is_open()) {
             throw SerialError("Failed to open file" + filename);
         }
+        for (const char c : saveMagic) writeChar(c);
+        writeInt(saveVersion);
     }
 
+    // streams have no header, they are read back by the same build in the current format
+    explicit Serializer(std::ostream& stream) : current_pos(0), file(stream) {}
+
     ~Serializer() {
-        file.close();
+        if (fileStream.is_open()) fileStream.close();
     }
 };
 
 class Deserializer {
-    std::ifstream file;
+    std::ifstream fileStream;
+    std::istream& file;
 
 
 public:
+    // format version of what is being read, see saveVersion
+    int version = saveVersion;
 
     std::string readString() {
         std::ostringstream os;
@@ -459,6 +499,14 @@ public:
         return l;
     }
 
+    std::string readBytes() {
+        const size_t size = readSizeT();
+        std::string data(size, '\0');
+        file.read(data.data(), static_cast<std::streamsize>(size));
+        if (static_cast<size_t>(file.gcount()) != size) throw SerialError("Corrupted save file");
+        return data;
+    }
+
     long long readLong() {
         char buf[8];
         file.read(buf, 8);
@@ -533,27 +581,34 @@ public:
     }
 
     Component* readComponent(std::vector<Reference>& relocTable, Actor* act) {
-        std::string type = readString();
+        // names are resolved once here, ids aren't stable between runs so saves keep the name
+        const ComponentType type = ComponentTypes::id(readString());
         bool initialized = readBool();
         Component* component;
-        if (type == "Rigidbody") {
-            component = new RigidBody(*this, act);
-            component->first = dynamic_cast<RigidBody *>(component);
+        if (type == ComponentTypes::Rigidbody) {
+            auto* rb = new RigidBody(*this, act);
+            component = rb;
+            component->first = rb;
             component->type = type;
             component->initialized = initialized;
         }
-        else if (type == "ParticleSystem") {
-            component = new ParticleSystem(*this);
-            component->first = dynamic_cast<ParticleSystem *>(component);
+        else if (type == ComponentTypes::ParticleSystem) {
+            auto* ps = new ParticleSystem(*this);
+            component = ps;
+            component->first = ps;
             component->type = type;
             component->initialized = initialized;
         }
+        else if (const NativeType* native = NativeComponents::find(type)) {
+            component = native->read(*this, act);
+            component->initialized = initialized;
+        }
         else {
             component = new Component();
             component->type = type;
             component->initialized = initialized;
             component->first = readTable(relocTable);
-            luabridge::LuaRef tableBase = getBaseComponent(type);
+            luabridge::LuaRef tableBase = getBaseComponent(ComponentTypes::name(type));
             // copy functions from component
             luabridge::Iterator it(tableBase);
             while (!it.isNil()) {
@@ -597,12 +652,26 @@ public:
         return component;
     }
 
-    Actor* readActor(std::vector<Reference>& relocTable) {
-        auto* act = new Actor();
+    // into is an actor without components to fill in, such as one the WorldStreamer unloaded
+    Actor* readActor(std::vector<Reference>& relocTable, Actor* into = nullptr) {
+        Actor* act = into ? into : new Actor();
+        act->tags = 0;
         act->uuid = readSizeT();
+        // ids given out from now on must not collide with the loaded ones
+        Actor::lastUUID = std::max<unsigned long long>(Actor::lastUUID, act->uuid);
         act->name = readString();
         act->dontDestroy = readBool();
         act->serialize = readBool();
+        if (version >= 1) {
+            size_t tags = readSizeT();
+            for (size_t i = 0; i < tags; i++) {
+                act->tags |= TagTable::bit(TagTable::id(readString()));
+            }
+        }
+        if (version >= 2) {
+            act->hasPosition = readBool();
+            act->position = readb2Vec2();
+        }
         size_t comps = readSizeT();
         for (int i = 0; i < comps; i++) {
             std::string key = readString();
@@ -628,8 +697,9 @@ public:
         scene.name = name;
         for (int i = 0; i < size; ++i) {
             scene.actors.push_back(readActor(relocTable));
-            scene.actorsByName[scene.actors.back()->name].push_back(scene.actors.back());
+            scene.indexActor(scene.actors.back());
         }
+        if (version >= 3) scene.streamer.read(*this);
         return scene;
     }
 
@@ -639,15 +709,29 @@ public:
         return {x, y};
     }
 
-    explicit Deserializer(const std::string &filename) {
-        file.open(filename, std::ios_base::binary);
-        if (!file.is_open()) {
+    explicit Deserializer(const std::string &filename) : file(fileStream) {
+        fileStream.open(filename, std::ios_base::binary);
+        if (!fileStream.is_open()) {
             throw SerialError("Failed to open file");
         }
+        // saves without the header start with a bool or a count, which can never spell the magic
+        char magic[sizeof(saveMagic)];
+        file.read(magic, sizeof(magic));
+        if (file.gcount() == sizeof(magic) && memcmp(magic, saveMagic, sizeof(magic)) == 0) {
+            version = readInt();
+            if (version > saveVersion) throw SerialError("Save file is from a newer version");
+        }
+        else {
+            file.clear();
+            file.seekg(0);
+            version = 0;
+        }
     }
 
+    explicit Deserializer(std::istream& stream) : file(stream) {}
+
     ~Deserializer() {
-        file.close();
+        if (fileStream.is_open()) fileStream.close();
     }
 };
 
@@ -0,0 +1,109 @@
+// Times the same methods called from lua through LuaBridge and through the hand written bindings of
+// src/FastBindings.h, to check that replacing a LuaBridge method is still worth it
+// usage: binding_bench [calls per method]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "lua.hpp"
+#include "LuaBridge.h"
+
+#include "FastBindings.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+
+// stand ins for b2::Vec2 and a Rigidbody, the engine classes need Box2D and a scene
+struct Vec {
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+struct Body {
+    Vec position{1.0f, 2.0f};
+    float rotation = 0.0f;
+
+    [[nodiscard]] float getRotation() const { return rotation; }
+    void setRotation(float degrees) { rotation = degrees; }
+    [[nodiscard]] Vec getPosition() const { return position; }
+    void setPosition(Vec pos) { position = pos; }
+};
+
+static int fastGetRotation(lua_State* L) {
+    lua_pushnumber(L, FastBindings::self<Body>(L)->getRotation());
+    return 1;
+}
+
+static int fastSetRotation(lua_State* L) {
+    FastBindings::self<Body>(L)->setRotation(static_cast<float>(luaL_checknumber(L, 2)));
+    return 0;
+}
+
+static int fastGetPosition(lua_State* L) {
+    luabridge::Stack<Vec>::push(L, FastBindings::self<Body>(L)->getPosition());
+    return 1;
+}
+
+static int fastSetPosition(lua_State* L) {
+    FastBindings::self<Body>(L)->setPosition(luabridge::Stack<Vec>::get(L, 2));
+    return 0;
+}
+
+// nanoseconds per call of body:method(args), including the loop around it
+static double nsPerCall(lua_State* L, const string& method, const string& args, long calls) {
+    const string code = "local body, v = body, Vec() for i = 1, " + std::to_string(calls) + " do body:" + method + "(" + args + ") end";
+    if (luaL_loadstring(L, code.c_str()) != LUA_OK) {
+        cout << "error: " << lua_tostring(L, -1) << endl;
+        exit(1);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
+        cout << "error: " << lua_tostring(L, -1) << endl;
+        exit(1);
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() * 1e9 / static_cast<double>(calls);
+}
+
+int main(int argc, char* argv[]) {
+    const long calls = argc > 1 ? std::atol(argv[1]) : 5000000;
+    lua_State* L = luaL_newstate();
+    luaL_openlibs(L);
+    luabridge::getGlobalNamespace(L)
+        .beginClass<Vec>("Vec")
+        .addConstructor<void(*)()>()
+        .addProperty("x", &Vec::x)
+        .addProperty("y", &Vec::y)
+        .endClass()
+        .beginClass<Body>("Body")
+        .addFunction("GetRotation", &Body::getRotation)
+        .addFunction("SetRotation", &Body::setRotation)
+        .addFunction("GetPosition", &Body::getPosition)
+        .addFunction("SetPosition", &Body::setPosition)
+        .endClass();
+    FastBindings::replaceMethods<Body>(L, {
+        {"FastGetRotation", fastGetRotation},
+        {"FastSetRotation", fastSetRotation},
+        {"FastGetPosition", fastGetPosition},
+        {"FastSetPosition", fastSetPosition},
+    });
+    Body body;
+    luabridge::setGlobal(L, &body, "body");
+
+    struct Case {
+        const char* method;
+        const char* args;
+    };
+    const Case cases[] = {{"GetRotation", ""}, {"SetRotation", "i"}, {"GetPosition", ""}, {"SetPosition", "v"}};
+    cout << "method          luabridge ns   raw ns   speedup" << endl;
+    for (const Case& c : cases) {
+        const double bridged = nsPerCall(L, c.method, c.args, calls);
+        const double raw = nsPerCall(L, string("Fast") + c.method, c.args, calls);
+        printf("%-15s %12.1f %8.1f %8.2fx\n", c.method, bridged, raw, bridged / raw);
+    }
+    lua_close(L);
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Compiles .scene files, along with the templates they use, into the binary format the engine
+// loads in place of the json when it is present
+// usage: scene_compiler [resources directory] [scene names...]
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "SceneBinary.h"
+#include "SceneDesc.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+int main(int argc, char* argv[]) {
+    const string resources = argc > 1 ? argv[1] : "resources";
+    const string sceneDir = resources + "/scenes/";
+    const string templateDir = resources + "/actor_templates/";
+    if (!std::filesystem::exists(sceneDir)) {
+        cout << "error: " << sceneDir << " missing" << endl;
+        return 1;
+    }
+
+    vector<string> scenes;
+    for (int i = 2; i < argc; i++) {
+        scenes.push_back(sceneDir + argv[i] + ".scene");
+    }
+    if (scenes.empty()) {
+        for (const auto& entry : std::filesystem::directory_iterator(sceneDir)) {
+            if (entry.path().extension() == ".scene") scenes.push_back(entry.path().string());
+        }
+    }
+
+    for (const string& path : scenes) {
+        if (!std::filesystem::exists(path)) {
+            cout << "error: scene " << path << " is missing" << endl;
+            return 1;
+        }
+        SceneDesc scene;
+        if (string error; !readSceneDesc(path, templateDir, scene, error)) {
+            cout << error << endl;
+            return 1;
+        }
+        if (!writeCompiledScene(compiledScenePath(path), scene, templateDir)) {
+            cout << "error: failed to write " << compiledScenePath(path) << endl;
+            return 1;
+        }
+        cout << "compiled " << path << " (" << scene.actors.size() << " actors)" << endl;
+    }
+    return 0;
+}